@@ -0,0 +1,48 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+//Counts every global heap allocation of the program (the default pmr resource ends up here too)
+//by replacing the global operator new/delete: include it from the benchmark's main file only.
+
+namespace bench{
+
+inline std::atomic<std::size_t> allocation_count{0};
+
+inline std::size_t allocations()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+}
+
+//none of the replacements is inlined: GCC would otherwise pair the malloc()/free() inside them with the
+//new/delete expressions of the callers and report -Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(std::size_t t_size)
+{
+    bench::allocation_count.fetch_add(1,std::memory_order_relaxed);
+    if(void* p = std::malloc(t_size ? t_size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+//over-aligned types (Device) and std::pmr::new_delete_resource() go through the aligned overloads
+__attribute__((noinline)) void* operator new(std::size_t t_size,std::align_val_t t_alignment)
+{
+    bench::allocation_count.fetch_add(1,std::memory_order_relaxed);
+    const std::size_t alignment = static_cast<std::size_t>(t_alignment);
+    if(void* p = std::aligned_alloc(alignment,(t_size+alignment-1)/alignment*alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* t_p) noexcept {std::free(t_p);}
+__attribute__((noinline)) void operator delete(void* t_p,std::size_t) noexcept {std::free(t_p);}
+__attribute__((noinline)) void operator delete(void* t_p,std::align_val_t) noexcept {std::free(t_p);}
+__attribute__((noinline)) void operator delete(void* t_p,std::size_t,std::align_val_t) noexcept {std::free(t_p);}
+
+#endif // ALLOC_COUNTER_H
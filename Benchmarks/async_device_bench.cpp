@@ -0,0 +1,135 @@
+/*
+    Serving thousands of fd-backed devices: every device is one end of a socketpair, echoing what the
+    simulated peer on the other end sends (64-byte messages, a fixed number of round trips per device).
+      - thread per device: blocking read/write, one thread for each end of each pair
+      - coroutines: AsyncDevice + one Reactor, every end is a coroutine and everything runs on one thread
+
+    Build & run:
+        g++ -O2 -std=c++20 -pthread -I../moderncpp1 async_device_bench.cpp ../moderncpp1/async_device.cpp \
+            ../moderncpp1/reactor.cpp ../moderncpp1/device.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out [device_count]
+*/
+
+#include <cstdlib>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "async_device.h"
+#include "bench_util.h"
+
+static const std::size_t MESSAGE_SIZE = 64;
+static const std::size_t ROUND_TRIPS = 100;
+
+static void socketPair(int t_fds[2])
+{
+    if(::socketpair(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0,t_fds)<0)
+        throw std::runtime_error("socketpair failed (raise the open file limit for more devices)");
+}
+
+static bool readFully(int t_fd,BYTE* t_data,std::size_t t_count)
+{
+    while(t_count)
+    {
+        ssize_t result = ::read(t_fd,t_data,t_count);
+        if(result<=0)
+            return false;
+        t_data += result;
+        t_count -= static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+static void runThreads(std::size_t t_device_count)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(2*t_device_count);
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_device_count;++i)
+    {
+        int fds[2];
+        socketPair(fds);
+        threads.emplace_back([fd=fds[0]]{
+            BYTE message[MESSAGE_SIZE];
+            while(readFully(fd,message,MESSAGE_SIZE))
+                ::write(fd,message,MESSAGE_SIZE);
+            ::close(fd);
+        });
+        threads.emplace_back([fd=fds[1]]{
+            BYTE message[MESSAGE_SIZE]{};
+            for(std::size_t trip=0;trip<ROUND_TRIPS;++trip)
+            {
+                ::write(fd,message,MESSAGE_SIZE);
+                readFully(fd,message,MESSAGE_SIZE);
+            }
+            ::close(fd);
+        });
+    }
+    for(std::thread& thread:threads)
+        thread.join();
+    bench::report("thread per device (2 threads/pair)",watch.elapsedNs(),t_device_count*ROUND_TRIPS);
+}
+
+static Task<DATA_SIZE> readFully(AsyncDevice& t_port,BYTE* t_data,DATA_SIZE t_count)
+{
+    DATA_SIZE done = 0;
+    while(done<t_count)
+    {
+        DATA_SIZE received = co_await t_port.read(t_data+done,t_count-done);
+        if(received==0)
+            break;
+        done += received;
+    }
+    co_return done;
+}
+
+static Task<void> echo(AsyncDevice& t_port)
+{
+    BYTE message[MESSAGE_SIZE];
+    while(co_await readFully(t_port,message,MESSAGE_SIZE)==MESSAGE_SIZE)
+        co_await t_port.write(message,MESSAGE_SIZE);
+}
+
+static Task<void> peer(std::unique_ptr<AsyncDevice> t_port)
+{
+    BYTE message[MESSAGE_SIZE]{};
+    for(std::size_t trip=0;trip<ROUND_TRIPS;++trip)
+    {
+        co_await t_port->write(message,MESSAGE_SIZE);
+        co_await readFully(*t_port,message,MESSAGE_SIZE);
+    }
+    //closing our end makes the echo side see the end of stream
+}
+
+static void runCoroutines(std::size_t t_device_count)
+{
+    std::deque<Device> devices;
+    std::vector<std::unique_ptr<AsyncDevice>> ports;
+    ports.reserve(t_device_count);
+    bench::Stopwatch watch;
+    Reactor reactor;
+    for(std::size_t i=0;i<t_device_count;++i)
+    {
+        int fds[2];
+        socketPair(fds);
+        Device& device = devices.emplace_back(KEYBOARD,READY,DEFAULT_BUFFER_CAPACITY);
+        Device& peer_device = devices.emplace_back(GPIO,READY,DEFAULT_BUFFER_CAPACITY);
+        ports.push_back(std::make_unique<AsyncDevice>(reactor,device,fds[0]));
+        reactor.spawn(echo(*ports.back()));
+        reactor.spawn(peer(std::make_unique<AsyncDevice>(reactor,peer_device,fds[1])));
+    }
+    reactor.run();
+    ports.clear();
+    bench::report("coroutines on one epoll reactor",watch.elapsedNs(),t_device_count*ROUND_TRIPS);
+    std::printf("%-48s %12llu wakeups\n","",static_cast<unsigned long long>(reactor.wakeups()));
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 2000;
+    std::printf("%zu devices, %zu round trips of %zu bytes each\n",device_count,ROUND_TRIPS,MESSAGE_SIZE);
+    runThreads(device_count);
+    runCoroutines(device_count);
+    return 0;
+}
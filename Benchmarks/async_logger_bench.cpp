@@ -0,0 +1,65 @@
+/*
+    Caller-side cost of logging: synchronous stream output flushed with std::endl on every line
+    (what writeLogByRef does) against AsyncLogBackend, where the caller only enqueues.
+    Both write to a file in the temp directory.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../CommonMistakes async_logger_bench.cpp && ./a.out [threads]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "AsyncLogger.h"
+
+int main(int argc, char *argv[])
+{
+    const unsigned threads = argc>1 ? std::strtoul(argv[1],nullptr,10) : 2;
+    const std::size_t messages = 200000;
+    const std::string sync_path = "/tmp/async_logger_bench_sync.log";
+    const std::string async_path = "/tmp/async_logger_bench_async.log";
+    MyLogger logger("device 42 changed status to READY");
+    const std::string message = logger.getMessage();
+
+    {
+        std::ofstream out(sync_path,std::ios::trunc);
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<messages;++i)
+            out<<message<<std::endl;
+        bench::report("sync  ostream << std::endl (1 thread)",watch.elapsedNs(),messages);
+    }
+
+    for(OverflowPolicy policy:{OverflowPolicy::Block,OverflowPolicy::Drop})
+    {
+        std::remove(async_path.c_str());
+        AsyncLogOptions options;
+        options.overflow = policy;
+        options.queue_capacity = 4096;
+        AsyncLogBackend backend(async_path,options);
+
+        bench::Stopwatch watch;
+        std::vector<std::thread> producers;
+        for(unsigned t=0;t<threads;++t)
+            producers.emplace_back([&]{
+                for(std::size_t i=0;i<messages;++i)
+                    backend.log(message);
+            });
+        for(auto& producer:producers)
+            producer.join();
+        const double enqueue_ns = watch.elapsedNs();
+        backend.flush();
+        const double total_ns = watch.elapsedNs();
+
+        const std::string name = policy==OverflowPolicy::Block ? "block" : "drop";
+        bench::report("async "+name+" enqueue ("+std::to_string(threads)+" threads)",enqueue_ns,messages*threads);
+        bench::report("async "+name+" enqueue + flush to file",total_ns,messages*threads);
+        std::printf("%-48s %12llu dropped\n","",static_cast<unsigned long long>(backend.droppedRecords()));
+    }
+    std::remove(sync_path.c_str());
+    std::remove(async_path.c_str());
+    return 0;
+}
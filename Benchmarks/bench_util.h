@@ -0,0 +1,154 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Tiny helpers shared by the benchmark programs in this folder.
+//Build every benchmark with optimizations on, e.g.: g++ -O2 -std=c++17 ...
+//Machine-readable results: set BENCH_RESULTS=<file>.json (one document per run, overwritten)
+//or BENCH_RESULTS=<file>.csv (rows appended, so several benchmarks can share one file).
+
+namespace bench{
+
+//prevents the optimizer from dropping a computed value
+template<typename T>
+inline void doNotOptimize(const T& t_value)
+{
+    asm volatile("" : : "r,m"(t_value) : "memory");
+}
+
+class Stopwatch{
+public:
+    Stopwatch():m_start{std::chrono::steady_clock::now()}{}
+    void restart(){m_start=std::chrono::steady_clock::now();}
+    double elapsedNs() const
+    {
+        return std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-m_start).count();
+    }
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+struct Result{
+    std::string name;
+    double total_ns;
+    std::size_t operations;
+    double allocations_per_op;      //negative when the benchmark does not count allocations
+};
+
+//collects every reported result and writes them to $BENCH_RESULTS when the program exits
+class ResultSink{
+public:
+    static ResultSink& instance()
+    {
+        static ResultSink sink;
+        return sink;
+    }
+
+    void add(const Result& t_result){m_results.push_back(t_result);}
+    Result* last(){return m_results.empty() ? nullptr : &m_results.back();}
+
+    ~ResultSink()
+    {
+        const char* path = std::getenv("BENCH_RESULTS");
+        if(path==nullptr || m_results.empty())
+            return;
+        const std::size_t length = std::strlen(path);
+        if(length>4 && std::strcmp(path+length-4,".csv")==0)
+            writeCsv(path);
+        else
+            writeJson(path);
+    }
+
+private:
+    static std::string quoted(const std::string& t_text)
+    {
+        std::string result = "\"";
+        for(char c:t_text)
+        {
+            if(c=='"' || c=='\\')
+                result += '\\';
+            result += c;
+        }
+        return result+"\"";
+    }
+
+    static double perOp(const Result& t_result)
+    {
+        return t_result.operations ? t_result.total_ns/static_cast<double>(t_result.operations) : 0.0;
+    }
+
+    void writeJson(const char* t_path) const
+    {
+        std::FILE* out = std::fopen(t_path,"w");
+        if(out==nullptr)
+            return;
+        std::fprintf(out,"{\"benchmark\": %s, \"results\": [",quoted(program_invocation_short_name).c_str());
+        for(std::size_t i=0;i<m_results.size();++i)
+        {
+            const Result& r = m_results[i];
+            std::fprintf(out,"%s\n  {\"name\": %s, \"total_ns\": %.1f, \"operations\": %zu, \"ns_per_op\": %.3f",
+                         i ? "," : "",quoted(r.name).c_str(),r.total_ns,r.operations,perOp(r));
+            if(r.allocations_per_op>=0)
+                std::fprintf(out,", \"allocations_per_op\": %.3f",r.allocations_per_op);
+            std::fprintf(out,"}");
+        }
+        std::fprintf(out,"\n]}\n");
+        std::fclose(out);
+    }
+
+    void writeCsv(const char* t_path) const
+    {
+        std::FILE* out = std::fopen(t_path,"a");
+        if(out==nullptr)
+            return;
+        if(std::ftell(out)==0)
+            std::fprintf(out,"benchmark,name,total_ns,operations,ns_per_op,allocations_per_op\n");
+        for(const Result& r:m_results)
+        {
+            std::fprintf(out,"%s,%s,%.1f,%zu,%.3f,",quoted(program_invocation_short_name).c_str(),quoted(r.name).c_str(),
+                         r.total_ns,r.operations,perOp(r));
+            if(r.allocations_per_op>=0)
+                std::fprintf(out,"%.3f",r.allocations_per_op);
+            std::fprintf(out,"\n");
+        }
+        std::fclose(out);
+    }
+
+    std::vector<Result> m_results;
+};
+
+//prints one result line: name, total time and per-operation cost
+inline void report(const std::string& t_name,double t_total_ns,std::size_t t_operations)
+{
+    std::printf("%-48s %12.3f ms %10.2f ns/op\n",t_name.c_str(),t_total_ns/1e6,
+                t_operations ? t_total_ns/static_cast<double>(t_operations) : 0.0);
+    ResultSink::instance().add(Result{t_name,t_total_ns,t_operations,-1.0});
+}
+
+//prints the allocation cost of the result reported just before
+inline void reportAllocations(std::size_t t_allocations,std::size_t t_operations,const char* t_unit="op")
+{
+    const double per_op = t_operations ? static_cast<double>(t_allocations)/static_cast<double>(t_operations) : 0.0;
+    std::printf("%-48s %12.2f allocations/%s\n","",per_op,t_unit);
+    if(Result* last = ResultSink::instance().last())
+        last->allocations_per_op = per_op;
+}
+
+//the samples print from their constructors: mute std::cout while timing so we measure the code, not the terminal
+class MuteStdout{
+public:
+    MuteStdout(){std::cout.setstate(std::ios::badbit);}
+    ~MuteStdout(){std::cout.clear();}
+};
+
+}
+
+#endif // BENCH_UTIL_H
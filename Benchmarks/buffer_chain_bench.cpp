@@ -0,0 +1,51 @@
+/*
+    Message assembly from many chunks: BufferChain (operator+ on moved DataBuffers) against building
+    one contiguous buffer by reallocating and copying on every concatenation.
+
+    Build & run:
+        g++ -O2 -std=c++17 -I../MoveSemantics buffer_chain_bench.cpp && ./a.out
+*/
+
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "BufferChain.h"
+
+int main()
+{
+    const std::string chunk(1024,'c');
+    bench::MuteStdout mute;
+
+    for(std::size_t chunks:{16u,256u,1024u})
+    {
+        std::vector<DataBuffer> frames;
+        frames.reserve(chunks);
+        for(std::size_t i=0;i<chunks;++i)
+            frames.emplace_back(chunk.c_str());
+
+        //contiguous concatenation: every step allocates size+chunk bytes and copies everything so far
+        bench::Stopwatch watch;
+        DataBuffer flat(0u);
+        for(const DataBuffer& frame:frames)
+        {
+            DataBuffer grown(flat.size()+frame.size());
+            Byte* out = grown.getMutableData();
+            out = std::copy(flat.getData(),flat.getData()+flat.size(),out);
+            std::copy(frame.getData(),frame.getData()+frame.size(),out);
+            flat = std::move(grown);
+        }
+        bench::report("concat copy   "+std::to_string(chunks)+" x 1 KiB",watch.elapsedNs(),chunks);
+
+        watch.restart();
+        BufferChain message;
+        for(DataBuffer& frame:frames)
+            message = std::move(message) + std::move(frame);
+        bench::report("concat chain  "+std::to_string(chunks)+" x 1 KiB",watch.elapsedNs(),chunks);
+
+        watch.restart();
+        DataBuffer contiguous = message.flatten();
+        bench::report("chain flatten "+std::to_string(chunks)+" x 1 KiB",watch.elapsedNs(),chunks);
+        bench::doNotOptimize(contiguous.getData()[contiguous.size()-1]);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+    DataBuffer byte kernels (ByteKernels.h) on buffers of a few KB: the scalar versions against the
+    SSE4.2 and AVX2 versions picked at runtime, for find(byte), find(pattern), equals and crc32c.
+    hash() (XXH64) has a single version and is reported for reference.
+
+    Build & run (no -mavx2 needed: the SIMD kernels carry their own target attributes):
+        g++ -O2 -std=c++17 -I../MoveSemantics byte_kernels_bench.cpp && ./a.out [buffer_size]
+*/
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "DataBuffer.h"
+
+static const char* isaName(bytekernels::Isa t_isa)
+{
+    switch(t_isa)
+    {
+        case bytekernels::Isa::Avx2: return "avx2";
+        case bytekernels::Isa::Sse42: return "sse4.2";
+        default: return "scalar";
+    }
+}
+
+template<typename Operation>
+static double run(const std::string& t_name,std::size_t t_iterations,std::size_t t_bytes,Operation t_operation)
+{
+    std::size_t sink = 0;
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_iterations;++i)
+        sink += t_operation();
+    const double ns = watch.elapsedNs();
+    bench::doNotOptimize(sink);
+    bench::report(t_name,ns,t_iterations);
+    std::printf("%-48s %12.2f GB/s\n","",static_cast<double>(t_bytes)*t_iterations/ns);
+    return ns;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t size = argc>1 ? std::strtoul(argv[1],nullptr,10) : 4096;
+    const std::size_t iterations = (1u<<28)/size;
+    bench::MuteStdout mute;
+
+    //binary payload without the searched bytes, NUL bytes included
+    std::vector<Byte> bytes(size);
+    for(std::size_t i=0;i<size;++i)
+        bytes[i] = static_cast<Byte>(i%7==0 ? 0 : 'a'+i%13);
+    const Byte pattern[]={'<','E','N','D','>'};
+    std::copy(pattern,pattern+sizeof(pattern),bytes.end()-sizeof(pattern));
+    const DataBuffer buffer(bytes.data(),size);
+    const DataBuffer same(bytes.data(),size);
+
+    const bytekernels::Isa best = bytekernels::detectIsa();
+    std::printf("buffer: %zu bytes, best kernels on this CPU: %s\n",size,isaName(best));
+
+    for(bytekernels::Isa isa:{bytekernels::Isa::Scalar,bytekernels::Isa::Sse42,bytekernels::Isa::Avx2})
+    {
+        if(static_cast<int>(isa)>static_cast<int>(best))
+            break;
+        bytekernels::setIsa(isa);
+        const std::string suffix = std::string(" [")+isaName(isa)+"]";
+        run("find(byte) at the end"+suffix,iterations,size,[&]{return buffer.find('>');});
+        run("find(pattern) at the end"+suffix,iterations,size,[&]{return buffer.find(pattern,sizeof(pattern));});
+        run("equals"+suffix,iterations,size,[&]{return static_cast<std::size_t>(buffer.equals(same));});
+        run("crc32c"+suffix,iterations,size,[&]{return static_cast<std::size_t>(buffer.crc32c());});
+    }
+    run("hash (XXH64)",iterations,size,[&]{return static_cast<std::size_t>(buffer.hash());});
+    return 0;
+}
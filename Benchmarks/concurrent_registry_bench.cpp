@@ -0,0 +1,134 @@
+/*
+    Scaling benchmark of ConcurrentDeviceRegistry against a DeviceRegistry behind a std::shared_mutex.
+    Every thread runs the same mix on a registry preloaded with devices:
+      - 95% lookups of a random preloaded id (reading the device status)
+      - 5% churn: create a new device, or retire the one this thread created last
+    The thread count goes from 1 up to the number of hardware threads (or the first argument).
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 concurrent_registry_bench.cpp ../moderncpp1/device.cpp \
+            ../moderncpp1/device_registry.cpp ../moderncpp1/concurrent_device_registry.cpp \
+            ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/epoch_reclamation.cpp ../moderncpp1/status_notifier.cpp \
+            ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "concurrent_device_registry.h"
+#include "device_registry.h"
+
+static const std::size_t PRELOADED_DEVICES = 100000;
+static const std::size_t OPS_PER_THREAD = 400000;
+static const unsigned CHURN_PERCENT = 5;
+
+//small per-thread generator: no shared state between threads
+struct XorShift{
+    std::uint64_t state;
+    std::uint64_t next(){state^=state<<13;state^=state>>7;state^=state<<17;return state;}
+};
+
+class LockedRegistry{
+public:
+    int emplace()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        return m_registry.find(m_registry.emplace(KEYBOARD,READY,0))->getId();
+    }
+    bool erase(int t_id)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        return m_registry.eraseById(t_id);
+    }
+    int status(int t_id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        const Device* device = m_registry.findById(t_id);
+        return device ? device->getStatusCode() : -1;
+    }
+private:
+    mutable std::shared_mutex m_mutex;
+    DeviceRegistry m_registry;
+};
+
+class LockFreeRegistry{
+public:
+    int emplace(){return m_registry.emplace(KEYBOARD,READY,0);}
+    bool erase(int t_id){return m_registry.erase(t_id);}
+    int status(int t_id) const
+    {
+        int result = -1;
+        m_registry.read(t_id,[&](const Device& t_device){result=t_device.getStatusCode();});
+        return result;
+    }
+private:
+    ConcurrentDeviceRegistry m_registry;
+};
+
+template<typename Registry>
+static double run(unsigned t_threads)
+{
+    Registry registry;
+    std::vector<int> ids;
+    ids.reserve(PRELOADED_DEVICES);
+    for(std::size_t i=0;i<PRELOADED_DEVICES;++i)
+        ids.push_back(registry.emplace());
+
+    std::vector<std::thread> workers;
+    bench::Stopwatch watch;
+    for(unsigned t=0;t<t_threads;++t)
+        workers.emplace_back([&,t]{
+            XorShift random{0x9E3779B97F4A7C15ull*(t+1)};
+            std::vector<int> own;
+            long checksum = 0;
+            for(std::size_t op=0;op<OPS_PER_THREAD;++op)
+            {
+                const std::uint64_t r = random.next();
+                if(r%100<CHURN_PERCENT)
+                {
+                    if(own.empty() || (r>>8)&1)
+                        own.push_back(registry.emplace());
+                    else
+                    {
+                        registry.erase(own.back());
+                        own.pop_back();
+                    }
+                }
+                else
+                    checksum += registry.status(ids[(r>>16)%ids.size()]);
+            }
+            bench::doNotOptimize(checksum);
+        });
+    for(auto& worker:workers)
+        worker.join();
+    return watch.elapsedNs();
+}
+
+int main(int argc,char* argv[])
+{
+    bench::MuteStdout mute;
+    const unsigned max_threads = argc>1 ? std::max(1,std::atoi(argv[1])) : std::max(1u,std::thread::hardware_concurrency());
+    std::printf("%u hardware threads, %zu preloaded devices, %zu ops per thread, %u%% churn\n",
+                max_threads,PRELOADED_DEVICES,OPS_PER_THREAD,CHURN_PERCENT);
+
+    std::vector<unsigned> counts;
+    for(unsigned n=1;n<max_threads;n*=2)
+        counts.push_back(n);
+    counts.push_back(max_threads);
+
+    for(unsigned n:counts)
+    {
+        const std::size_t ops = n*OPS_PER_THREAD;
+        const double locked = run<LockedRegistry>(n);
+        const double lock_free = run<LockFreeRegistry>(n);
+        bench::report("shared_mutex DeviceRegistry, "+std::to_string(n)+" threads",locked,ops);
+        bench::report("ConcurrentDeviceRegistry, "+std::to_string(n)+" threads",lock_free,ops);
+        std::printf("%-48s %12.2f Mops/s vs %.2f Mops/s\n","  aggregate throughput",ops/lock_free*1e3,ops/locked*1e3);
+    }
+    return 0;
+}
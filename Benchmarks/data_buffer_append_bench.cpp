@@ -0,0 +1,85 @@
+/*
+    A long-lived DataBuffer on a receive loop: messages of varying size (16 B .. 4 KiB) are stored one
+    after the other, and every message is also assembled from several fragments.
+      - fresh buffer: what setData did before (release the storage, then allocate exactly the new size)
+      - setData / clear + append: the storage is kept and grows geometrically, the loop stops allocating
+        once the largest message has been seen
+
+    Build & run:
+        g++ -O2 -std=c++17 -I../MoveSemantics data_buffer_append_bench.cpp && ./a.out [messages]
+*/
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "DataBuffer.h"
+
+static const std::size_t FRAGMENTS = 4;
+
+int main(int argc, char *argv[])
+{
+    const std::size_t messages = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    bench::MuteStdout mute;
+
+    std::vector<Byte> wire(4096);
+    for(std::size_t i=0;i<wire.size();++i)
+        wire[i] = static_cast<Byte>(i*31);
+    std::mt19937 random(42);
+    std::vector<std::size_t> sizes(1024);
+    for(std::size_t& size:sizes)
+        size = 16+random()%(wire.size()-16);
+
+    {
+        DataBuffer buffer(0u);
+        std::size_t checksum = 0;
+        const std::size_t allocations = bench::allocations();
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<messages;++i)
+        {
+            buffer = DataBuffer(wire.data(),sizes[i%sizes.size()]);
+            checksum += buffer.getData()[buffer.size()-1];
+        }
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(checksum);
+        bench::report("fresh buffer per message",ns,messages);
+        bench::reportAllocations(bench::allocations()-allocations,messages,"message");
+    }
+    {
+        DataBuffer buffer(0u);
+        std::size_t checksum = 0;
+        const std::size_t allocations = bench::allocations();
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<messages;++i)
+        {
+            buffer.setData(wire.data(),sizes[i%sizes.size()]);
+            checksum += buffer.getData()[buffer.size()-1];
+        }
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(checksum);
+        bench::report("setData (storage reused)",ns,messages);
+        bench::reportAllocations(bench::allocations()-allocations,messages,"message");
+    }
+    {
+        DataBuffer buffer(0u);
+        std::size_t checksum = 0;
+        const std::size_t allocations = bench::allocations();
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<messages;++i)
+        {
+            //the message arrives in FRAGMENTS reads
+            const std::size_t size = sizes[i%sizes.size()];
+            buffer.clear();
+            for(std::size_t f=0;f<FRAGMENTS;++f)
+                buffer.append(wire.data()+size*f/FRAGMENTS,size*(f+1)/FRAGMENTS-size*f/FRAGMENTS);
+            checksum += buffer.getData()[buffer.size()-1];
+        }
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(checksum);
+        bench::report("clear + append of 4 fragments",ns,messages);
+        bench::reportAllocations(bench::allocations()-allocations,messages,"message");
+        std::printf("%-48s %12zu bytes of capacity at the end\n","",buffer.capacity());
+    }
+    return 0;
+}
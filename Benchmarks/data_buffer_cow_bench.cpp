@@ -0,0 +1,82 @@
+/*
+    Allocation count and throughput of the copy-on-write / small-buffer DataBuffer against the
+    previous implementation, which deep-copied on every copy (kept below as LegacyDataBuffer).
+
+    Build & run:
+        g++ -O2 -std=c++17 -I../MoveSemantics data_buffer_cow_bench.cpp && ./a.out
+*/
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "DataBuffer.h"
+
+//the deep-copy DataBuffer this benchmark compares against (with the same tracepoints, so only storage differs)
+class LegacyDataBuffer{
+public:
+    explicit LegacyDataBuffer(const char* t_data):m_data_size{static_cast<unsigned int>(strlen(t_data))},m_data{new Byte[m_data_size]}
+    {
+        LIFECYCLE_TRACE(this,"Default Constructor used. Based on Initial Data.");
+        std::copy(t_data,t_data+m_data_size,m_data);
+    }
+    LegacyDataBuffer(const LegacyDataBuffer& other):m_data_size{other.m_data_size},m_data{new Byte[m_data_size]}
+    {
+        std::copy(other.m_data,other.m_data+m_data_size,m_data);
+        LIFECYCLE_TRACE(this,"Copy Constructor used");
+    }
+    LegacyDataBuffer& operator=(const LegacyDataBuffer&)=delete;
+    ~LegacyDataBuffer(){delete[] m_data;LIFECYCLE_TRACE(this,"Default Destructor invoked");}
+    const Byte* getData() const {return m_data;}
+    //the old way to hand a part of a buffer to someone else: copy it out
+    LegacyDataBuffer sub(unsigned int t_offset,unsigned int t_length) const
+    {
+        std::string part(reinterpret_cast<const char*>(m_data)+t_offset,t_length);
+        return LegacyDataBuffer(part.c_str());
+    }
+private:
+    unsigned int m_data_size;
+    Byte* m_data;
+};
+
+template<typename Buffer,typename Operation>
+void run(const std::string& t_name,std::size_t t_iterations,Operation t_operation)
+{
+    const std::size_t allocations_before = bench::allocations();
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_iterations;++i)
+        t_operation();
+    const double ns = watch.elapsedNs();
+    bench::report(t_name,ns,t_iterations);
+    bench::reportAllocations(bench::allocations()-allocations_before,t_iterations);
+}
+
+int main()
+{
+    const std::size_t iterations = 1000000;
+    const std::string large(4096,'x');
+    bench::MuteStdout mute;
+
+    {
+        LegacyDataBuffer small("Hello");
+        DataBuffer small_cow("Hello");
+        run<LegacyDataBuffer>("copy 5 bytes     legacy deep copy",iterations,[&]{LegacyDataBuffer c(small);bench::doNotOptimize(c.getData()[0]);});
+        run<DataBuffer>("copy 5 bytes     inline (SBO)",iterations,[&]{DataBuffer c(small_cow);bench::doNotOptimize(c.getData()[0]);});
+    }
+    {
+        LegacyDataBuffer big(large.c_str());
+        DataBuffer big_cow(large.c_str());
+        run<LegacyDataBuffer>("copy 4 KiB       legacy deep copy",iterations,[&]{LegacyDataBuffer c(big);bench::doNotOptimize(c.getData()[0]);});
+        run<DataBuffer>("copy 4 KiB       shared (COW)",iterations,[&]{DataBuffer c(big_cow);bench::doNotOptimize(c.getData()[0]);});
+        run<LegacyDataBuffer>("1 KiB part of 4 KiB   legacy copy-out",iterations,[&]{LegacyDataBuffer c(big.sub(1024,1024));bench::doNotOptimize(c.getData()[0]);});
+        run<DataBuffer>("1 KiB part of 4 KiB   slice",iterations,[&]{DataBuffer c(big_cow.slice(1024,1024));bench::doNotOptimize(c.getData()[0]);});
+
+        //fan out one received buffer to 8 consumers
+        run<LegacyDataBuffer>("fan-out 4 KiB to 8 consumers legacy",iterations/8,[&]{
+            std::vector<LegacyDataBuffer> consumers(8,big);bench::doNotOptimize(consumers[7].getData()[0]);});
+        run<DataBuffer>("fan-out 4 KiB to 8 consumers COW",iterations/8,[&]{
+            std::vector<DataBuffer> consumers(8,big_cow);bench::doNotOptimize(consumers[7].getData()[0]);});
+    }
+    return 0;
+}
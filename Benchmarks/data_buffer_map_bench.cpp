@@ -0,0 +1,116 @@
+/*
+    Loading a large replay file into a DataBuffer: read() + copy into a heap buffer vs DataBuffer::map().
+    For each: time to get a usable buffer, resident memory (RSS) right after, and after touching
+    1% of the pages at random. The file is dropped from the page cache (fsync + POSIX_FADV_DONTNEED)
+    before each run, so both start cold.
+
+    Build & run:
+        g++ -O2 -std=c++17 -I../MoveSemantics data_buffer_map_bench.cpp && ./a.out [size_mb]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench_util.h"
+#include "DataBuffer.h"
+
+static std::size_t residentBytes()
+{
+    long pages_total = 0,pages_resident = 0;
+    if(std::FILE* statm = std::fopen("/proc/self/statm","r"))
+    {
+        if(std::fscanf(statm,"%ld %ld",&pages_total,&pages_resident)!=2)
+            pages_resident = 0;
+        std::fclose(statm);
+    }
+    return static_cast<std::size_t>(pages_resident)*static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+static void writeFile(const std::string& t_path,std::size_t t_size)
+{
+    const int fd = ::open(t_path.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+    std::vector<char> chunk(1<<20);
+    for(std::size_t i=0;i<chunk.size();++i)
+        chunk[i] = static_cast<char>('a'+i%26);
+    for(std::size_t written=0;written<t_size;written+=chunk.size())
+        if(::write(fd,chunk.data(),std::min(chunk.size(),t_size-written))<0)
+            break;
+    ::close(fd);
+}
+
+//reads one byte in 1% of the pages
+static unsigned touchPages(const DataBuffer& t_buffer)
+{
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t pages = t_buffer.size()/page;
+    std::mt19937_64 random(7);
+    unsigned sum = 0;
+    for(std::size_t i=0;i<pages/100;++i)
+        sum += t_buffer.getData()[(random()%pages)*page];
+    return sum;
+}
+
+static void dropFromPageCache(const std::string& t_path)
+{
+    const int fd = ::open(t_path.c_str(),O_RDONLY);
+    ::fdatasync(fd);
+    ::posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+static void measure(const char* t_name,std::size_t t_size,DataBuffer (*t_load)(const std::string&),const std::string& t_path)
+{
+    dropFromPageCache(t_path);
+    const std::size_t rss_before = residentBytes();
+    bench::Stopwatch watch;
+    DataBuffer buffer = t_load(t_path);
+    bench::report(std::string(t_name)+" load",watch.elapsedNs(),1);
+    const std::size_t rss_loaded = residentBytes();
+    watch.restart();
+    bench::doNotOptimize(touchPages(buffer));
+    bench::report(std::string(t_name)+" touch 1% of pages",watch.elapsedNs(),t_size/static_cast<std::size_t>(::sysconf(_SC_PAGESIZE))/100);
+    const std::size_t rss_touched = residentBytes();
+    std::printf("%-48s RSS +%zu MB after load, +%zu MB after touching\n","",(rss_loaded-rss_before)>>20,(rss_touched-rss_before)>>20);
+}
+
+static DataBuffer readAndCopy(const std::string& t_path)
+{
+    const int fd = ::open(t_path.c_str(),O_RDONLY);
+    const off_t size = ::lseek(fd,0,SEEK_END);
+    ::lseek(fd,0,SEEK_SET);
+    DataBuffer buffer(static_cast<unsigned int>(size));
+    Byte* out = buffer.getMutableData();
+    for(off_t done=0;done<size;)
+    {
+        const ssize_t n = ::read(fd,out+done,static_cast<std::size_t>(size-done));
+        if(n<=0)
+            break;
+        done += n;
+    }
+    ::close(fd);
+    return buffer;
+}
+
+static DataBuffer mapRandom(const std::string& t_path)
+{
+    return DataBuffer::map(t_path,DataBuffer::Access::Random);
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t size = (argc>1 ? std::strtoul(argv[1],nullptr,10) : 256)<<20;
+    const std::string path = "/tmp/data_buffer_map_bench.bin";
+    bench::MuteStdout mute;
+    writeFile(path,size);
+    std::printf("file: %zu MB\n",size>>20);
+
+    measure("read() + copy",size,readAndCopy,path);
+    measure("DataBuffer::map (Random)",size,mapRandom,path);
+
+    std::remove(path.c_str());
+    return 0;
+}
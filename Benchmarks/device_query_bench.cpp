@@ -0,0 +1,101 @@
+/*
+    Type/status queries: full scan of the devices vs the DeviceBitmapIndex kept by DeviceRegistry.
+      - registry part: "all FAULT printers" and "IDLE devices per type" on real devices, both ways
+      - index part: the same queries on a 10M slot DeviceBitmapIndex (10M Device objects would not fit in memory here)
+
+    Build & run (the AVX2 kernel is picked at runtime when the CPU has it):
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 device_query_bench.cpp ../moderncpp1/device.cpp ../moderncpp1/device_registry.cpp \
+            ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/status_notifier.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp
+        ./a.out [registry_devices] [index_slots]
+*/
+
+#include <array>
+#include <cstdlib>
+#include <random>
+#include "bench_util.h"
+#include "device_bitmap_index.h"
+#include "device_registry.h"
+
+static const int REPEAT = 20;
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    const std::size_t slot_count = argc>2 ? std::strtoul(argv[2],nullptr,10) : 10000000;
+    bench::MuteStdout mute;
+    std::mt19937 random(42);
+
+    std::printf("registry devices: %zu\n",device_count);
+    DeviceRegistry registry(device_count);
+    for(std::size_t i=0;i<device_count;++i)
+        registry.emplace(static_cast<DEVICE_TYPE>(random()%DEVICE_TYPE_COUNT),static_cast<DEVICE_STATUS>(random()%DEVICE_STATUS_COUNT),0);
+
+    bench::Stopwatch watch;
+    std::size_t found = 0;
+    for(int r=0;r<REPEAT;++r)
+        for(const Device& device:registry)
+            found += device.getTypeCode()==PRINTER && device.getStatusCode()==FAULT;
+    bench::doNotOptimize(found);
+    bench::report("scan   count FAULT printers",watch.elapsedNs()/REPEAT,device_count);
+
+    const DeviceQuery fault_printers = DeviceQuery().type(PRINTER).status(FAULT);
+    watch.restart();
+    std::size_t counted = 0;
+    for(int r=0;r<REPEAT;++r)
+        counted += registry.count(fault_printers);
+    bench::doNotOptimize(counted);
+    bench::report("bitmap count FAULT printers",watch.elapsedNs()/REPEAT,device_count);
+    if(counted!=found)
+        std::printf("MISMATCH: scan %zu, bitmap %zu\n",found,counted);
+
+    watch.restart();
+    std::array<std::size_t,DEVICE_TYPE_COUNT> per_type{};
+    for(int r=0;r<REPEAT;++r)
+        for(const Device& device:registry)
+            per_type[device.getTypeCode()] += device.getStatusCode()==IDLE;
+    bench::doNotOptimize(per_type);
+    bench::report("scan   IDLE devices per type",watch.elapsedNs()/REPEAT,device_count);
+
+    watch.restart();
+    for(int r=0;r<REPEAT;++r)
+        bench::doNotOptimize(registry.countByType(IDLE));
+    bench::report("bitmap IDLE devices per type",watch.elapsedNs()/REPEAT,device_count);
+
+    watch.restart();
+    std::size_t visited = 0;
+    registry.forEachMatch(fault_printers,[&](Device&){++visited;});
+    bench::report("bitmap visit FAULT printers",watch.elapsedNs(),device_count);
+    bench::doNotOptimize(visited);
+
+    std::printf("index slots: %zu\n",slot_count);
+    DeviceBitmapIndex index;
+    for(std::size_t slot=0;slot<slot_count;++slot)
+        index.add(slot,static_cast<DEVICE_TYPE>(random()%DEVICE_TYPE_COUNT),static_cast<DEVICE_STATUS>(random()%DEVICE_STATUS_COUNT));
+
+    watch.restart();
+    for(int r=0;r<REPEAT;++r)
+        bench::doNotOptimize(index.count(fault_printers));
+    bench::report("bitmap count FAULT printers",watch.elapsedNs()/REPEAT,slot_count);
+
+    const DeviceQuery compound = DeviceQuery().type(PRINTER).type(DISPLAY).status(FAULT).status(STOPPED);
+    watch.restart();
+    for(int r=0;r<REPEAT;++r)
+        bench::doNotOptimize(index.count(compound));
+    bench::report("bitmap count (PRINTER|DISPLAY)&(FAULT|STOPPED)",watch.elapsedNs()/REPEAT,slot_count);
+
+    watch.restart();
+    for(int r=0;r<REPEAT;++r)
+        bench::doNotOptimize(index.countByType(IDLE));
+    bench::report("bitmap IDLE devices per type",watch.elapsedNs()/REPEAT,slot_count);
+
+    watch.restart();
+    for(int r=0;r<REPEAT;++r)
+        bench::doNotOptimize(index.select(fault_printers).wordCount());
+    bench::report("bitmap select FAULT printers",watch.elapsedNs()/REPEAT,slot_count);
+
+    watch.restart();
+    for(std::size_t slot=0;slot<slot_count;slot+=7)
+        index.updateStatus(slot,index.statusBitmap(FAULT).test(slot) ? FAULT : READY,STOPPED);
+    bench::report("bitmap status updates",watch.elapsedNs(),slot_count/7);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+    Compares the old device list (std::vector<std::unique_ptr<Device>>) with DeviceRegistry (slot map + id index)
+    for insertion, lookup by id and full iteration.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 device_registry_bench.cpp ../moderncpp1/device.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp ../moderncpp1/device_registry.cpp \
+            ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/status_notifier.cpp
+        ./a.out [device_count]
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "bench_util.h"
+#include "device.h"
+#include "device_registry.h"
+
+static const DEVICE_TYPE types[]={GPIO,KEYBOARD,MOUSE,DISPLAY,PRINTER};
+static const DEVICE_STATUS statuses[]={READY,STARTING,IDLE,FAULT,STOPPED};
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 200000;
+    //a linear search per lookup is O(n): keep the vector lookup count small enough to finish
+    const std::size_t vector_lookups = 500;
+    const std::size_t registry_lookups = device_count;
+    bench::MuteStdout mute;
+
+    std::printf("devices: %zu\n",device_count);
+
+    //insert
+    std::vector<std::unique_ptr<Device>> device_list;
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<device_count;++i)
+        device_list.push_back(std::make_unique<Device>(types[i%5],statuses[i%5],DEFAULT_BUFFER_CAPACITY));
+    bench::report("insert  vector<unique_ptr<Device>>",watch.elapsedNs(),device_count);
+
+    DeviceRegistry registry(device_count);
+    std::vector<DeviceHandle> handles;
+    handles.reserve(device_count);
+    watch.restart();
+    for(std::size_t i=0;i<device_count;++i)
+        handles.push_back(registry.emplace(types[i%5],statuses[i%5],DEFAULT_BUFFER_CAPACITY));
+    bench::report("insert  DeviceRegistry",watch.elapsedNs(),device_count);
+
+    //lookup by id (random ids, same sequence for both)
+    std::mt19937 rng(42);
+    std::vector<int> vector_ids(vector_lookups),registry_ids(registry_lookups);
+    std::uniform_int_distribution<std::size_t> pick(0,device_count-1);
+    for(auto& id:vector_ids) id = device_list[pick(rng)]->getId();
+    for(auto& id:registry_ids) id = registry.find(handles[pick(rng)])->getId();
+
+    long checksum=0;
+    watch.restart();
+    for(int id:vector_ids)
+    {
+        auto it = std::find_if(device_list.begin(),device_list.end(),[id](const auto& d){return d->getId()==id;});
+        checksum += (*it)->getStatusCode();
+    }
+    bench::report("lookup  vector<unique_ptr<Device>> (linear)",watch.elapsedNs(),vector_lookups);
+
+    watch.restart();
+    for(int id:registry_ids)
+        checksum += registry.findById(id)->getStatusCode();
+    bench::report("lookup  DeviceRegistry (hash index)",watch.elapsedNs(),registry_lookups);
+
+    //full iteration
+    const int rounds = 20;
+    watch.restart();
+    for(int r=0;r<rounds;++r)
+        for(const auto& device:device_list)
+            checksum += device->getStatusCode();
+    bench::report("iterate vector<unique_ptr<Device>>",watch.elapsedNs(),device_count*rounds);
+
+    watch.restart();
+    for(int r=0;r<rounds;++r)
+        for(const auto& device:registry)
+            checksum += device.getStatusCode();
+    bench::report("iterate DeviceRegistry",watch.elapsedNs(),device_count*rounds);
+
+    bench::doNotOptimize(checksum);
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+    Two-thread benchmark of the lock-free SPSC ring buffer on the Device buffer:
+    a driver thread feeds the device with write_n while a consumer thread drains it with read_n.
+      - throughput: bytes per second for a few batch sizes
+      - latency: time from write() of a timestamp to its read() on the other thread
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 device_ring_bench.cpp ../moderncpp1/device.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "device.h"
+
+//spin a few times before yielding the core, so the benchmark also behaves on machines with few cores
+static void backoff(int& t_spins)
+{
+    if(++t_spins<64)
+        asm volatile("" ::: "memory");
+    else
+    {
+        t_spins = 0;
+        std::this_thread::yield();
+    }
+}
+
+static void throughput(DATA_SIZE t_capacity,DATA_SIZE t_batch,std::size_t t_total_bytes)
+{
+    Device device(t_capacity);
+    std::vector<BYTE> source(t_batch,0x5a),sink(t_batch);
+
+    bench::Stopwatch watch;
+    std::thread producer([&]{
+        std::size_t sent = 0;
+        int spins = 0;
+        while(sent<t_total_bytes)
+        {
+            DATA_SIZE n = device.write_n(source.data(),std::min<std::size_t>(t_batch,t_total_bytes-sent));
+            if(n==0) backoff(spins);
+            sent += n;
+        }
+    });
+    std::size_t received = 0;
+    int spins = 0;
+    while(received<t_total_bytes)
+    {
+        DATA_SIZE n = device.read_n(sink.data(),t_batch);
+        if(n==0) backoff(spins);
+        received += n;
+    }
+    producer.join();
+    const double ns = watch.elapsedNs();
+    std::printf("throughput capacity %6lu batch %5lu: %10.1f MB/s\n",t_capacity,t_batch,t_total_bytes/ns*1e3);
+}
+
+static void latency(std::size_t t_messages)
+{
+    typedef std::chrono::steady_clock::rep Tick;
+    Device device(DATA_SIZE{4096});
+    std::vector<double> samples;
+    samples.reserve(t_messages);
+
+    std::thread producer([&]{
+        int spins = 0;
+        for(std::size_t i=0;i<t_messages;++i)
+        {
+            //one message in flight at a time: wait until the consumer drained the previous one
+            while(device.getDataSize()!=0) backoff(spins);
+            Tick now = std::chrono::steady_clock::now().time_since_epoch().count();
+            device.write_n(reinterpret_cast<const BYTE*>(&now),sizeof(now));
+        }
+    });
+    int spins = 0;
+    for(std::size_t i=0;i<t_messages;++i)
+    {
+        Tick sent;
+        DATA_SIZE got = 0;
+        while(got<sizeof(sent))
+        {
+            DATA_SIZE n = device.read_n(reinterpret_cast<BYTE*>(&sent)+got,sizeof(sent)-got);
+            if(n==0) backoff(spins);
+            got += n;
+        }
+        samples.push_back(static_cast<double>(std::chrono::steady_clock::now().time_since_epoch().count()-sent));
+    }
+    producer.join();
+
+    std::sort(samples.begin(),samples.end());
+    auto percentile=[&](double p){return samples[static_cast<std::size_t>(p*(samples.size()-1))];};
+    std::printf("latency (ns): p50 %.0f  p99 %.0f  p99.9 %.0f  max %.0f  (%u hardware threads)\n",
+                percentile(0.5),percentile(0.99),percentile(0.999),samples.back(),std::thread::hardware_concurrency());
+}
+
+int main()
+{
+    const std::size_t total = std::size_t(256)<<20;
+    throughput(4096,1,total/64);
+    throughput(4096,64,total);
+    throughput(65536,1024,total);
+    latency(100000);
+    return 0;
+}
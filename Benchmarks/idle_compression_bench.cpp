@@ -0,0 +1,153 @@
+/*
+    Idle buffer compression (BufferCompressor, Device::compressBuffer, LzCodec):
+      - LzCodec throughput on one buffer of telemetry text
+      - sweep cost: first sweep (devices become idle, nothing compressed), second sweep after the idle time
+        (90% of the devices are IDLE and get compressed)
+      - memory given back, then the cost of waking the devices up again (lazy decompression on read)
+    Everything decoded is compared with the original bytes (codec round trips on random, repetitive and
+    empty inputs, full and partial decodes, then every device buffer): the bench fails on any difference.
+    The devices buffer printer telemetry text, the kind of data a parked device keeps around.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 idle_compression_bench.cpp ../moderncpp1/buffer_compressor.cpp \
+            ../moderncpp1/device.cpp ../moderncpp1/device_registry.cpp ../moderncpp1/device_bitmap_index.cpp \
+            ../moderncpp1/status_notifier.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp \
+            ../moderncpp1/string_interner.cpp && ./a.out [device_count]
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_util.h"
+#include "buffer_compressor.h"
+#include "lz_codec.h"
+
+static const DATA_SIZE BUFFER_CAPACITY = 4096;
+static const std::size_t CODEC_ROUNDS = 2000;
+
+//telemetry lines until t_size bytes
+static std::vector<BYTE> telemetry(std::size_t t_seed,std::size_t t_size)
+{
+    std::string text;
+    for(std::size_t line=0;text.size()<t_size;++line)
+        text += "ts="+std::to_string(1700000000+t_seed*60+line)+" temp="+std::to_string(20+(t_seed+line)%7)+"."
+                +std::to_string(line%10)+" fan="+std::to_string(1200+(line*37)%300)+" rpm status=OK\n";
+    return std::vector<BYTE>(text.begin(),text.begin()+static_cast<std::ptrdiff_t>(t_size));
+}
+
+//compress then decompress (fully and partially) inputs of every kind, false on the first difference
+static bool codecRoundTrips()
+{
+    std::mt19937 random(7);
+    for(int round=0;round<2000;++round)
+    {
+        const std::size_t size = random()%5000;
+        std::vector<BYTE> input(size);
+        const unsigned alphabet = 1u+random()%(round%3==0 ? 256 : 4);       //random bytes or long repeats
+        for(BYTE& byte:input)
+            byte = static_cast<BYTE>(random()%alphabet);
+        std::vector<BYTE> packed(size+16),output(size+1);
+        const std::size_t packed_size = LzCodec::compress(input.data(),size,packed.data(),packed.size());
+        if(packed_size==0)
+            continue;       //did not fit: stored as is by Device::compressBuffer
+        const std::size_t prefix = size ? random()%(size+1) : 0;
+        if(LzCodec::decompress(packed.data(),packed_size,output.data(),size)!=size
+           || std::memcmp(output.data(),input.data(),size)!=0
+           || LzCodec::decompress(packed.data(),packed_size,output.data(),prefix)!=prefix
+           || std::memcmp(output.data(),input.data(),prefix)!=0)
+        {
+            std::fprintf(stderr,"LzCodec round trip failed: %zu bytes, alphabet %u\n",size,alphabet);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 50000;
+    std::printf("%zu devices, %u byte buffers, 90%% of them idle\n",device_count,static_cast<unsigned>(BUFFER_CAPACITY));
+    if(!codecRoundTrips())
+        return 1;
+    bench::MuteStdout mute;
+    {
+        const std::vector<BYTE> plain = telemetry(0,BUFFER_CAPACITY);
+        std::vector<BYTE> packed(plain.size()),unpacked(plain.size());
+        std::size_t packed_size = 0;
+        bench::Stopwatch compress_watch;
+        for(std::size_t r=0;r<CODEC_ROUNDS;++r)
+            packed_size = LzCodec::compress(plain.data(),plain.size(),packed.data(),packed.size());
+        const double compress_ns = compress_watch.elapsedNs();
+        bench::Stopwatch decompress_watch;
+        for(std::size_t r=0;r<CODEC_ROUNDS;++r)
+            bench::doNotOptimize(LzCodec::decompress(packed.data(),packed_size,unpacked.data(),unpacked.size()));
+        const double decompress_ns = decompress_watch.elapsedNs();
+        bench::report("LzCodec::compress, one buffer",compress_ns,CODEC_ROUNDS);
+        bench::report("LzCodec::decompress, one buffer",decompress_ns,CODEC_ROUNDS);
+        std::printf("%-48s %12.1f MB/s compress %10.1f MB/s decompress, ratio %.2f\n","",
+                    plain.size()*CODEC_ROUNDS*1e3/compress_ns,plain.size()*CODEC_ROUNDS*1e3/decompress_ns,
+                    static_cast<double>(plain.size())/static_cast<double>(packed_size));
+    }
+
+    DeviceRegistry registry(device_count);
+    std::vector<DeviceHandle> handles;
+    handles.reserve(device_count);
+    for(std::size_t i=0;i<device_count;++i)
+    {
+        handles.push_back(registry.emplace(PRINTER,i%10==0 ? READY : IDLE,BUFFER_CAPACITY));
+        const std::vector<BYTE> data = telemetry(i,BUFFER_CAPACITY-i%512);
+        registry.find(handles.back())->write_n(data.data(),static_cast<DATA_SIZE>(data.size()));
+    }
+
+    const auto idle_time = std::chrono::seconds(30);
+    BufferCompressor compressor(idle_time);
+    const auto start = std::chrono::steady_clock::now();
+    {
+        bench::Stopwatch watch;
+        const std::size_t compressed = compressor.sweep(registry,start);
+        bench::report("sweep, devices just idle",watch.elapsedNs(),device_count);
+        std::printf("%-48s %12zu buffers compressed\n","",compressed);
+    }
+    {
+        bench::Stopwatch watch;
+        const std::size_t compressed = compressor.sweep(registry,start+idle_time);
+        bench::report("sweep, idle time elapsed",watch.elapsedNs(),device_count);
+        const BufferCompressionStats stats = BufferCompressor::stats();
+        const double ring_bytes = static_cast<double>(compressed*Device::bufferAllocationSize(BUFFER_CAPACITY));
+        std::printf("%-48s %12zu buffers compressed, %.1f MB saved of %.1f MB (%.1f%%)\n","",compressed,
+                    stats.bytes_saved/1e6,ring_bytes/1e6,100.0*stats.bytes_saved/ring_bytes);
+    }
+    {
+        bench::Stopwatch watch;
+        const std::size_t compressed = compressor.sweep(registry,start+2*idle_time);
+        bench::report("sweep, everything already compressed",watch.elapsedNs(),device_count);
+        std::printf("%-48s %12zu buffers compressed\n","",compressed);
+    }
+    {
+        //every device wakes up and drains its buffer: the compressed ones decompress first
+        std::vector<BYTE> data(device_count*BUFFER_CAPACITY);
+        std::vector<DATA_SIZE> sizes(device_count);
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<device_count;++i)
+            sizes[i] = registry.find(handles[i])->read_n(data.data()+i*BUFFER_CAPACITY,BUFFER_CAPACITY);
+        bench::report("read_n of every buffer (lazy decompression)",watch.elapsedNs(),device_count);
+        for(std::size_t i=0;i<device_count;++i)
+        {
+            const std::vector<BYTE> expected = telemetry(i,BUFFER_CAPACITY-i%512);
+            if(sizes[i]!=expected.size() || std::memcmp(data.data()+i*BUFFER_CAPACITY,expected.data(),expected.size())!=0)
+            {
+                std::fprintf(stderr,"device %zu: buffer differs after compression\n",i);
+                return 1;
+            }
+        }
+        const BufferCompressionStats stats = BufferCompressor::stats();
+        std::printf("%-48s %12llu decompressions: mean %.0f ns, p50 %llu ns, p99 %llu ns, max %llu ns\n","",
+                    static_cast<unsigned long long>(stats.decompressions),stats.decompression_mean_ns,
+                    static_cast<unsigned long long>(stats.decompression_p50_ns),
+                    static_cast<unsigned long long>(stats.decompression_p99_ns),
+                    static_cast<unsigned long long>(stats.decompression_max_ns));
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+    Per-operation latency histograms (Common/latency_histogram.h):
+      - recording overhead: cost of one LATENCY_SCOPE (two steady_clock reads, which dominate, plus a
+        per-thread histogram update)
+      - DataBuffer copy/move/setData from several threads, then the merged percentiles as text and JSON
+    This file turns the histograms on for itself (LATENCY_HISTOGRAMS=1), whatever the build options.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../MoveSemantics latency_histogram_bench.cpp && ./a.out [threads] [iterations]
+*/
+
+#ifndef LATENCY_HISTOGRAMS
+#define LATENCY_HISTOGRAMS 1
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "DataBuffer.h"
+
+static const std::size_t OVERHEAD_ITERATIONS = 10000000;
+
+static void bufferWorkload(std::size_t t_iterations)
+{
+    const std::string large(1000,'x');
+    DataBuffer source(large.c_str());
+    DataBuffer receive(0u);
+    std::size_t checksum = 0;
+    for(std::size_t i=0;i<t_iterations;++i)
+    {
+        DataBuffer copy(source);                //shares the block
+        DataBuffer moved(std::move(copy));
+        copy = moved;
+        moved = DataBuffer("small");
+        receive.setData(large.c_str()+i%500);
+        checksum += receive.size()+copy.size()+moved.size();
+    }
+    bench::doNotOptimize(checksum);
+}
+
+int main(int argc, char *argv[])
+{
+    const unsigned threads = argc>1 ? std::max(1,std::atoi(argv[1])) : std::max(2u,std::thread::hardware_concurrency());
+    const std::size_t iterations = argc>2 ? std::strtoul(argv[2],nullptr,10) : 200000;
+    {
+        bench::Stopwatch watch;
+        for(std::size_t i=0;i<OVERHEAD_ITERATIONS;++i)
+        {
+            LATENCY_SCOPE("empty scope");
+        }
+        bench::report("recording overhead (one LATENCY_SCOPE)",watch.elapsedNs(),OVERHEAD_ITERATIONS);
+    }
+    {
+        bench::MuteStdout mute;
+        std::vector<std::thread> workers;
+        bench::Stopwatch watch;
+        for(unsigned t=0;t<threads;++t)
+            workers.emplace_back(bufferWorkload,iterations);
+        for(auto& worker:workers)
+            worker.join();
+        bench::report("DataBuffer workload, "+std::to_string(threads)+" threads",watch.elapsedNs(),threads*iterations);
+    }
+    {
+        bench::Stopwatch watch;
+        const auto operations = latency::merged();
+        bench::report("merge of all thread histograms",watch.elapsedNs(),operations.size());
+    }
+    std::printf("\n");
+    latency::writeText(std::cout);
+    latency::writeJson(std::cout);
+    return 0;
+}
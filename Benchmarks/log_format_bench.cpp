@@ -0,0 +1,60 @@
+/*
+    Message formatting cost: virtual MyLogger::getMessage() (builds a new std::string on every call)
+    against the compile-time decorator stack of LogFormat.h formatting into a thread local buffer,
+    for records that pass the level filter and for records that are filtered out.
+
+    Build & run:
+        g++ -O2 -std=c++17 -I../CommonMistakes log_format_bench.cpp && ./a.out
+*/
+
+#include <cstdlib>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "Logger.h"
+#include "LogFormat.h"
+
+//what a caller does today: get the message through the base class reference, then filter
+static std::size_t virtualPath(const BaseLogger& t_logger,LogLevel t_level,LogLevel t_threshold,FormatBuffer& t_out)
+{
+    std::string message = t_logger.getMessage();
+    if(t_level<t_threshold)
+        return 0;
+    t_out.clear();
+    t_out.append(message);
+    return t_out.size();
+}
+
+template<typename Operation>
+static void run(const char* t_name,std::size_t t_iterations,Operation t_operation)
+{
+    const std::size_t allocations_before = bench::allocations();
+    std::size_t bytes = 0;
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_iterations;++i)
+        bytes += t_operation();
+    bench::report(t_name,watch.elapsedNs(),t_iterations);
+    bench::reportAllocations(bench::allocations()-allocations_before,t_iterations);
+    bench::doNotOptimize(bytes);
+}
+
+int main()
+{
+    const std::size_t iterations = 5000000;
+    const char* text = "device 42 changed status from STARTING to READY";
+    MyLogger virtual_logger(text);
+    const BaseLogger& base = virtual_logger;
+    MyStaticLogger static_logger(text,LogLevel::Info);
+    FormatBuffer out = FormatBuffer::threadLocal();
+
+    run("virtual getMessage()      passing record",iterations,[&]{return virtualPath(base,LogLevel::Warning,LogLevel::Info,out);});
+    run("compile-time decorators   passing record",iterations,[&]{
+        out.clear();
+        static_logger.formatTo(out,LogLevel::Warning);
+        return out.size();});
+    run("virtual getMessage()      filtered record",iterations,[&]{return virtualPath(base,LogLevel::Debug,LogLevel::Info,out);});
+    run("compile-time decorators   filtered record",iterations,[&]{
+        out.clear();
+        static_logger.formatTo(out,LogLevel::Debug);
+        return out.size();});
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+    Chained MyClass additions: eager operator+ (one temporary per +, the previous implementation, kept below
+    as LegacyMyClass) vs the expression templates of MyClassExpr.h, and the same for whole arrays:
+    eager std::vector temporaries vs the fused MyClassArray loop vs a hand-written loop.
+
+    Build & run (add -mavx2 or -march=native for 256-bit vectors):
+        g++ -O2 -std=c++17 -DLIFECYCLE_TRACE_MODE=LIFECYCLE_TRACE_OFF -I../MoveSemantics myclass_expr_bench.cpp && ./a.out [array_size]
+*/
+
+#include <cstdlib>
+#include <vector>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "MyClass.h"
+#include "MyClassArray.h"
+
+//the eager MyClass this benchmark compares against (same tracepoints)
+class LegacyMyClass{
+public:
+    explicit LegacyMyClass(int t_data):m_data{t_data}{LIFECYCLE_TRACE(this,"Regular value based constructor invoked: MyClass(int t_data)");}
+    LegacyMyClass():m_data{0}{}
+    LegacyMyClass(const LegacyMyClass& t_other):m_data{t_other.m_data}{LIFECYCLE_TRACE(this,"Copy Constructor invoked.");}
+    LegacyMyClass operator+(const LegacyMyClass& t_other) const
+    {
+        LegacyMyClass result;
+        result.m_data=m_data+t_other.m_data;
+        LIFECYCLE_TRACE(this,"Addition Operator invoked");
+        return result;
+    }
+    int data() const {return m_data;}
+private:
+    int m_data;
+};
+
+static std::vector<int> add(const std::vector<int>& t_left,const std::vector<int>& t_right)
+{
+    std::vector<int> result(t_left.size());
+    for(std::size_t i=0;i<t_left.size();++i)
+        result[i] = t_left[i]+t_right[i];
+    return result;
+}
+
+template<typename Operation>
+static void run(const char* t_name,std::size_t t_iterations,std::size_t t_elements,Operation t_operation)
+{
+    const std::size_t allocations_before = bench::allocations();
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_iterations;++i)
+        t_operation();
+    bench::report(t_name,watch.elapsedNs(),t_iterations*t_elements);
+    bench::reportAllocations(bench::allocations()-allocations_before,t_iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t array_size = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1<<20;
+    const std::size_t scalar_iterations = 10000000;
+    const std::size_t array_iterations = 100;
+    bench::MuteStdout mute;
+
+    int seed = 1;
+    run("MyClass a+b+c+d eager (temporaries)",scalar_iterations,1,[&]{
+        LegacyMyClass a(seed),b(2),c(3),d(4);
+        LegacyMyClass sum = a+b+c+d;
+        seed = sum.data()&0xff;
+    });
+    run("MyClass a+b+c+d expression template",scalar_iterations,1,[&]{
+        MyClass a(seed),b(2),c(3),d(4);
+        MyClass sum = a+b+c+d;
+        seed = sum.data()&0xff;
+    });
+    bench::doNotOptimize(seed);
+
+    std::printf("arrays of %zu elements, ns/op is per element\n",array_size);
+    std::vector<int> vx(array_size,1),vy(array_size,2),vz(array_size,3),vw(array_size,4),vout;
+    run("vector x+y+z+w eager (temporaries)",array_iterations,array_size,[&]{
+        vout = add(add(add(vx,vy),vz),vw);
+        bench::doNotOptimize(vout.data());
+    });
+
+    MyClassArray x(array_size,1),y(array_size,2),z(array_size,3),w(array_size,4),out(array_size);
+    run("MyClassArray x+y+z+w fused",array_iterations,array_size,[&]{
+        out = x+y+z+w;
+        bench::doNotOptimize(out.data());
+    });
+
+    run("hand-written loop",array_iterations,array_size,[&]{
+        int* result = out.data();
+        const int* xs = x.data();
+        const int* ys = y.data();
+        const int* zs = z.data();
+        const int* ws = w.data();
+        for(std::size_t i=0;i<array_size;++i)
+            result[i] = xs[i]+ys[i]+zs[i]+ws[i];
+        bench::doNotOptimize(result);
+    });
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+    Polling a fleet whose per-device service cost is very uneven: most devices take a short poll, while
+    1% of them (all in the same region of the registry, e.g. the printers of one site) cost 200 times more.
+      - sequential: the device loop of main.cpp
+      - static partition: one thread per contiguous slice of the registry
+      - WorkStealingPool: DeviceRegistry::parallelForEach, automatic chunking
+    Compare the speedups with the thread count given as first argument (default: all hardware threads).
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 parallel_poll_bench.cpp ../moderncpp1/device.cpp \
+            ../moderncpp1/device_registry.cpp ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/status_notifier.cpp \
+            ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp ../moderncpp1/work_stealing_pool.cpp && ./a.out [threads]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "bench_util.h"
+#include "device_registry.h"
+#include "work_stealing_pool.h"
+
+static const std::size_t DEVICE_COUNT = 200000;
+static const std::size_t EXPENSIVE_FACTOR = 200;
+
+//one poll: checksum the buffered bytes, t_rounds times
+static std::uint64_t poll(const Device& t_device,std::size_t t_rounds)
+{
+    BYTE data[DEFAULT_BUFFER_CAPACITY];
+    const DATA_SIZE size = t_device.peek_n(data,sizeof(data));
+    std::uint64_t hash = static_cast<std::uint64_t>(t_device.getId());
+    for(std::size_t round=0;round<t_rounds;++round)
+        for(DATA_SIZE i=0;i<size;++i)
+            hash = (hash^data[i])*0x100000001B3ull;
+    return hash;
+}
+
+//the expensive devices sit together, in the first 2% of the registry (every other device there)
+static std::size_t roundsFor(const Device& t_device,int t_first_id)
+{
+    const int offset = t_device.getId()-t_first_id;
+    return offset<static_cast<int>(DEVICE_COUNT/50) && offset%2==0 ? EXPENSIVE_FACTOR : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    const unsigned threads = argc>1 ? std::max(1,std::atoi(argv[1])) : std::max(1u,std::thread::hardware_concurrency());
+    std::printf("%zu devices, 1%% of them %zux more expensive, %u threads\n",DEVICE_COUNT,EXPENSIVE_FACTOR,threads);
+
+    DeviceRegistry registry(DEVICE_COUNT);
+    const int first_id = Device::next_device_id.load();
+    const BYTE payload[DEFAULT_BUFFER_CAPACITY]={1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16};
+    for(std::size_t i=0;i<DEVICE_COUNT;++i)
+        registry.find(registry.emplace(KEYBOARD,READY,DEFAULT_BUFFER_CAPACITY))->write_n(payload,sizeof(payload));
+    std::vector<const Device*> devices;
+    for(const Device& device:registry)
+        devices.push_back(&device);
+
+    double sequential_ns;
+    {
+        std::uint64_t checksum = 0;
+        bench::Stopwatch watch;
+        for(const Device* device:devices)
+            checksum ^= poll(*device,roundsFor(*device,first_id));
+        sequential_ns = watch.elapsedNs();
+        bench::doNotOptimize(checksum);
+        bench::report("sequential",sequential_ns,DEVICE_COUNT);
+    }
+    {
+        std::atomic<std::uint64_t> checksum{0};
+        std::vector<std::thread> workers;
+        bench::Stopwatch watch;
+        for(unsigned t=0;t<threads;++t)
+            workers.emplace_back([&,t]{
+                std::uint64_t local = 0;
+                for(std::size_t i=devices.size()*t/threads;i<devices.size()*(t+1)/threads;++i)
+                    local ^= poll(*devices[i],roundsFor(*devices[i],first_id));
+                checksum.fetch_xor(local,std::memory_order_relaxed);
+            });
+        for(auto& worker:workers)
+            worker.join();
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(checksum.load());
+        bench::report("static partition",ns,DEVICE_COUNT);
+        std::printf("%-48s %12.2fx speedup\n","",sequential_ns/ns);
+    }
+    for(bool pin:{false,true})
+    {
+        WorkStealingPool pool(WorkStealingOptions{threads,pin});
+        std::vector<std::uint64_t> results(DEVICE_COUNT);
+        bench::Stopwatch watch;
+        registry.parallelForEach(pool,[&](const Device& t_device){
+            results[static_cast<std::size_t>(t_device.getId()-first_id)] = poll(t_device,roundsFor(t_device,first_id));
+        });
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(results);
+        bench::report(pin ? "WorkStealingPool, pinned threads" : "WorkStealingPool",ns,DEVICE_COUNT);
+        std::printf("%-48s %12.2fx speedup, %llu steals\n","",sequential_ns/ns,static_cast<unsigned long long>(pool.steals()));
+    }
+    return 0;
+}
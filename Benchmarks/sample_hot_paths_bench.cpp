@@ -0,0 +1,111 @@
+/*
+    Hot paths of the samples themselves, each with its heap allocation count:
+      - copy vs move vs RVO (returned prvalue) for DataBuffer, Device and MyClass
+      - BaseLogger passed by value (sliced copy) vs by reference, as in CommonMistakes/object_slicing.cpp
+      - device creation through createDevice vs constructing straight into make_unique
+
+    Build & run (or: cmake --build <dir> --target bench):
+        g++ -O2 -std=c++17 -I../moderncpp1 -I../MoveSemantics -I../CommonMistakes sample_hot_paths_bench.cpp \
+            ../moderncpp1/device.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out [iterations]
+*/
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "DataBuffer.h"
+#include "device.h"
+#include "Logger.h"
+#include "MyClass.h"
+
+static const char PAYLOAD[] = "a sample payload longer than the inline buffer of DataBuffer";
+
+template<typename Operation>
+static void run(const std::string& t_name,std::size_t t_iterations,Operation t_operation)
+{
+    const std::size_t allocations_before = bench::allocations();
+    bench::Stopwatch watch;
+    for(std::size_t i=0;i<t_iterations;++i)
+        t_operation();
+    const double ns = watch.elapsedNs();
+    bench::report(t_name,ns,t_iterations);
+    bench::reportAllocations(bench::allocations()-allocations_before,t_iterations);
+}
+
+//not inlined, so the returned object really goes through the call boundary
+__attribute__((noinline)) static DataBuffer makeBuffer(){return DataBuffer(PAYLOAD);}
+__attribute__((noinline)) static Device makeDevice(){return Device(KEYBOARD,READY,DEFAULT_BUFFER_CAPACITY);}
+__attribute__((noinline)) static MyClass makeMyClass(int t_value){return MyClass(t_value);}
+
+__attribute__((noinline)) static std::size_t writeLogByVal(BaseLogger t_logger){return t_logger.getMessage().size();}
+__attribute__((noinline)) static std::size_t writeLogByRef(const BaseLogger& t_logger){return t_logger.getMessage().size();}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t iterations = argc>1 ? std::strtoul(argv[1],nullptr,10) : 200000;
+    bench::MuteStdout mute;
+    std::printf("iterations: %zu\n",iterations);
+
+    run("DataBuffer construct + copy",iterations,[]{
+        DataBuffer source(PAYLOAD);
+        DataBuffer copy(source);
+        bench::doNotOptimize(copy);
+    });
+    run("DataBuffer construct + move",iterations,[]{
+        DataBuffer source(PAYLOAD);
+        DataBuffer moved(std::move(source));
+        bench::doNotOptimize(moved);
+    });
+    run("DataBuffer RVO",iterations,[]{
+        DataBuffer returned = makeBuffer();
+        bench::doNotOptimize(returned);
+    });
+
+    run("Device construct + copy",iterations,[]{
+        Device source(KEYBOARD,READY,DEFAULT_BUFFER_CAPACITY);
+        Device copy(source);
+        bench::doNotOptimize(copy);
+    });
+    run("Device construct + move",iterations,[]{
+        Device source(KEYBOARD,READY,DEFAULT_BUFFER_CAPACITY);
+        Device moved(std::move(source));
+        bench::doNotOptimize(moved);
+    });
+    run("Device RVO",iterations,[]{
+        Device returned = makeDevice();
+        bench::doNotOptimize(returned);
+    });
+
+    int value = 0;
+    run("MyClass construct + copy",iterations,[&]{
+        MyClass source(++value);
+        MyClass copy(source);
+        bench::doNotOptimize(copy);
+    });
+    run("MyClass construct + move (copies: no move ctor)",iterations,[&]{
+        MyClass source(++value);
+        MyClass moved(std::move(source));
+        bench::doNotOptimize(moved);
+    });
+    run("MyClass RVO",iterations,[&]{
+        MyClass returned = makeMyClass(++value);
+        bench::doNotOptimize(returned);
+    });
+
+    const MyLogger logger("a log message long enough to leave the small string buffer");
+    std::size_t length = 0;
+    run("BaseLogger by value (sliced copy)",iterations,[&]{length += writeLogByVal(logger);});
+    run("BaseLogger by reference",iterations,[&]{length += writeLogByRef(logger);});
+    bench::doNotOptimize(length);
+
+    run("createDevice (temporary + move)",iterations,[]{
+        auto device = createDevice(PRINTER,READY);
+        bench::doNotOptimize(device);
+    });
+    run("make_unique<Device> in place",iterations,[]{
+        auto device = std::make_unique<Device>(PRINTER,READY,DEFAULT_BUFFER_CAPACITY);
+        bench::doNotOptimize(device);
+    });
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+    Status scan ("how many devices are READY") over a large fleet: the old Device layout vs the compact one.
+      - legacy layout: the previous Device, event log and cache-line padded ring indexes inline (320 bytes)
+      - compact layout: Device as it is now, hot fields only (event log in the DeviceColdStore, ring
+        indexes in the buffer block), in a plain vector and in a DeviceRegistry (slot = Device + generation)
+    The scan reads one status byte per device: the time is mostly cache misses, so it follows the bytes
+    (cache lines) per device. Hardware cache misses are read with perf_event_open when the kernel allows it.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 status_scan_bench.cpp ../moderncpp1/device.cpp \
+            ../moderncpp1/device_registry.cpp ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/status_notifier.cpp \
+            ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out [device_count]
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "bench_util.h"
+#include "device_registry.h"
+
+static const int REPEAT = 5;
+
+//the Device fields before the hot/cold split, in the same order
+struct LegacyDevice{
+    int id=0;
+    DEVICE_TYPE type=GPIO;
+    std::atomic<std::uint32_t> status{STARTING};
+    DeviceEventLog events;
+    std::pmr::memory_resource* resource=nullptr;
+    DATA_SIZE buffer_capacity=0;
+    BYTE* buffer=nullptr;
+    alignas(CACHE_LINE_SIZE) std::atomic<DATA_SIZE> write_index{0};
+    DATA_SIZE cached_read_index=0;
+    alignas(CACHE_LINE_SIZE) std::atomic<DATA_SIZE> read_index{0};
+    DATA_SIZE cached_write_index=0;
+
+    DEVICE_STATUS getStatusCode() const {return static_cast<DEVICE_STATUS>(status.load(std::memory_order_acquire) & 0xff);}
+};
+
+//hardware cache misses of this thread (user space only), -1 when perf events are not available
+class CacheMissCounter{
+public:
+    CacheMissCounter()
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes,0,sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        m_fd = static_cast<int>(::syscall(SYS_perf_event_open,&attributes,0,-1,-1,0));
+    }
+    ~CacheMissCounter()
+    {
+        if(m_fd>=0)
+            ::close(m_fd);
+    }
+
+    void start()
+    {
+        if(m_fd<0)
+            return;
+        ::ioctl(m_fd,PERF_EVENT_IOC_RESET,0);
+        ::ioctl(m_fd,PERF_EVENT_IOC_ENABLE,0);
+    }
+    long long stop()
+    {
+        long long count = -1;
+        if(m_fd<0)
+            return count;
+        ::ioctl(m_fd,PERF_EVENT_IOC_DISABLE,0);
+        if(::read(m_fd,&count,sizeof(count))!=sizeof(count))
+            count = -1;
+        return count;
+    }
+
+private:
+    int m_fd;
+};
+
+template<typename Devices>
+static void scan(const char* t_name,const Devices& t_devices,std::size_t t_device_count,std::size_t t_bytes_per_device)
+{
+    CacheMissCounter misses;
+    std::size_t ready = 0;
+    misses.start();
+    bench::Stopwatch watch;
+    for(int r=0;r<REPEAT;++r)
+        for(const auto& device:t_devices)
+            ready += device.getStatusCode()==READY;
+    const double ns = watch.elapsedNs();
+    const long long miss_count = misses.stop();
+    bench::doNotOptimize(ready);
+    bench::report(t_name,ns/REPEAT,t_device_count);
+    const std::size_t scans = static_cast<std::size_t>(REPEAT)*t_device_count;
+    if(miss_count>=0)
+        std::printf("%-48s %5zu bytes/device %8.3f cache lines/device %8.3f cache misses/device\n","",t_bytes_per_device,
+                    static_cast<double>(t_bytes_per_device)/CACHE_LINE_SIZE,static_cast<double>(miss_count)/scans);
+    else
+        std::printf("%-48s %5zu bytes/device %8.3f cache lines/device      n/a cache misses/device\n","",t_bytes_per_device,
+                    static_cast<double>(t_bytes_per_device)/CACHE_LINE_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    std::printf("%zu devices, sizeof legacy Device %zu, sizeof Device %zu\n",device_count,sizeof(LegacyDevice),sizeof(Device));
+    bench::MuteStdout mute;
+    {
+        //the atomics make LegacyDevice immovable: construct them all in place, then fill them in
+        std::vector<LegacyDevice> devices(device_count);
+        for(std::size_t i=0;i<device_count;++i)
+        {
+            devices[i].id = static_cast<int>(i);
+            devices[i].type = static_cast<DEVICE_TYPE>(i%DEVICE_TYPE_COUNT);
+            devices[i].status.store(static_cast<std::uint32_t>(i%DEVICE_STATUS_COUNT),std::memory_order_relaxed);
+        }
+        scan("legacy layout, vector",devices,device_count,sizeof(LegacyDevice));
+    }
+    {
+        std::vector<Device> devices;
+        devices.reserve(device_count);
+        for(std::size_t i=0;i<device_count;++i)
+            devices.emplace_back(static_cast<DEVICE_TYPE>(i%DEVICE_TYPE_COUNT),static_cast<DEVICE_STATUS>(i%DEVICE_STATUS_COUNT),DEFAULT_BUFFER_CAPACITY);
+        scan("compact layout, vector",devices,device_count,sizeof(Device));
+    }
+    {
+        DeviceRegistry registry(device_count);
+        for(std::size_t i=0;i<device_count;++i)
+            registry.emplace(static_cast<DEVICE_TYPE>(i%DEVICE_TYPE_COUNT),static_cast<DEVICE_STATUS>(i%DEVICE_STATUS_COUNT),DEFAULT_BUFFER_CAPACITY);
+        //a registry slot is the Device plus its 32-bit generation, rounded to the Device alignment
+        const std::size_t slot_size = (sizeof(Device)+sizeof(std::uint32_t)+alignof(Device)-1)/alignof(Device)*alignof(Device);
+        scan("compact layout, DeviceRegistry",registry,device_count,slot_size);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+    Status storm: every device of a 100k fleet goes READY -> IDLE -> FAULT -> STARTING -> READY, the devices
+    being split between the threads, with one monitor watching the changes.
+      - synchronous: the monitor is called for every change, behind a mutex
+      - StatusNotifier: changes are buffered per thread and handed to the monitor in coalesced batches
+    Both use the lock-free ConcurrentDeviceRegistry::setStatus (compare-and-swap on the status).
+
+    Build & run:
+        g++ -O2 -std=c++20 -pthread -I../moderncpp1 status_storm_bench.cpp ../moderncpp1/device.cpp \
+            ../moderncpp1/concurrent_device_registry.cpp ../moderncpp1/epoch_reclamation.cpp \
+            ../moderncpp1/status_notifier.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out [threads]
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench_util.h"
+#include "concurrent_device_registry.h"
+#include "status_notifier.h"
+
+static const std::size_t DEVICE_COUNT = 100000;
+static const DEVICE_STATUS STORM[] = {IDLE,FAULT,STARTING,READY};
+
+//what a monitor does: count the devices per status, and push its summary out once per call
+//(one write(2) to /dev/null, standing for a UI refresh or a message to a dashboard)
+struct Monitor{
+    Monitor():fd{::open("/dev/null",O_WRONLY|O_CLOEXEC)}{}
+    ~Monitor(){::close(fd);}
+    void onChange(const StatusChange& t_change){++per_status[t_change.to];}
+    void publishSummary()
+    {
+        ++calls;
+        bench::doNotOptimize(::write(fd,per_status,sizeof(per_status)));
+    }
+    int fd;
+    std::size_t calls=0;
+    std::size_t per_status[DEVICE_STATUS_COUNT]={};
+};
+
+template<typename Publish>
+static double storm(const std::vector<int>& t_ids,unsigned t_threads,Publish&& t_publish)
+{
+    std::vector<std::thread> workers;
+    bench::Stopwatch watch;
+    for(unsigned t=0;t<t_threads;++t)
+        workers.emplace_back([&,t]{
+            const std::size_t first = t_ids.size()*t/t_threads,last = t_ids.size()*(t+1)/t_threads;
+            for(DEVICE_STATUS status:STORM)
+                for(std::size_t i=first;i<last;++i)
+                    t_publish(t_ids[i],status);
+        });
+    for(auto& worker:workers)
+        worker.join();
+    return watch.elapsedNs();
+}
+
+int main(int argc,char* argv[])
+{
+    const unsigned threads = argc>1 ? std::max(1,std::atoi(argv[1])) : std::max(1u,std::thread::hardware_concurrency());
+    const std::size_t changes = DEVICE_COUNT*std::size(STORM);
+    std::printf("%zu devices, %zu status changes, %u threads\n",DEVICE_COUNT,changes,threads);
+
+    ConcurrentDeviceRegistry registry;
+    std::vector<int> ids;
+    for(std::size_t i=0;i<DEVICE_COUNT;++i)
+        ids.push_back(registry.emplace(KEYBOARD,READY,0));
+
+    {
+        Monitor monitor;
+        std::mutex monitor_mutex;
+        const double ns = storm(ids,threads,[&](int t_id,DEVICE_STATUS t_status){
+            StatusChange change;
+            if(registry.setStatus(t_id,t_status,&change))
+            {
+                std::lock_guard<std::mutex> lock(monitor_mutex);
+                monitor.onChange(change);
+                monitor.publishSummary();
+            }
+        });
+        bench::report("synchronous callback per change",ns,changes);
+        std::printf("%-48s %12zu monitor calls\n","",monitor.calls);
+    }
+    {
+        Monitor monitor;
+        StatusNotifier notifier;
+        notifier.subscribe([&](const std::vector<StatusChange>& t_batch){
+            for(const StatusChange& change:t_batch)
+                monitor.onChange(change);
+            monitor.publishSummary();
+        });
+        registry.setStatusNotifier(&notifier);
+        const double ns = storm(ids,threads,[&](int t_id,DEVICE_STATUS t_status){
+            registry.setStatus(t_id,t_status);
+        });
+        notifier.flush();
+        bench::report("StatusNotifier batches",ns,changes);
+        std::printf("%-48s %12zu monitor calls, %llu changes delivered\n","",monitor.calls,
+                    static_cast<unsigned long long>(notifier.deliveredChanges()));
+        registry.setStatusNotifier(nullptr);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+    Exporting the state of 1M devices: the text loop of main.cpp (one label string copy per lookup, as
+    getTypeLabel()/getStatusLabel() used to return) against the columnar TelemetryExporter.
+    Both write to /dev/null so only the export path is measured.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 telemetry_export_bench.cpp ../moderncpp1/device.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp \
+            ../moderncpp1/device_registry.cpp ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/status_notifier.cpp \
+            ../moderncpp1/telemetry_exporter.cpp && ./a.out [device_count]
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "telemetry_exporter.h"
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    DeviceRegistry registry(device_count);
+    for(std::size_t i=0;i<device_count;++i)
+        registry.emplace(static_cast<DEVICE_TYPE>(i%DEVICE_TYPE_COUNT),static_cast<DEVICE_STATUS>(i%DEVICE_STATUS_COUNT),DEFAULT_BUFFER_CAPACITY);
+
+    {
+        std::ofstream out("/dev/null");
+        std::size_t allocations_before = bench::allocations();
+        bench::Stopwatch watch;
+        for(const auto& device:registry)
+        {
+            const std::string type = device.getTypeLabel();
+            const std::string status = device.getStatusLabel();
+            out<<"Device #"<<device.getId()<<" -> Type: "<<type<<" -> Status: "<<status<<"\n";
+        }
+        out.flush();
+        bench::report("text loop with label copies",watch.elapsedNs(),device_count);
+        bench::reportAllocations(bench::allocations()-allocations_before,device_count,"device");
+    }
+    {
+        std::size_t allocations_before = bench::allocations();
+        bench::Stopwatch watch;
+        TelemetryExporter exporter(std::string("/dev/null"));
+        exporter.exportSnapshot(registry);
+        exporter.finish();
+        bench::report("columnar TelemetryExporter",watch.elapsedNs(),device_count);
+        bench::reportAllocations(bench::allocations()-allocations_before,device_count,"device");
+        std::printf("%-48s %12llu bytes\n","",static_cast<unsigned long long>(exporter.bytesWritten()));
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+    Restarting with a large fleet: recreating every device through its constructor against a DeviceSnapshot.
+      - constructors: one DeviceRegistry::emplace (and one buffer allocation) per device
+      - snapshot open + lookups: map the file, then look up a few devices by id (what a restart that
+        serves requests right away needs); the minor page faults show how little of the file is touched
+      - snapshot restoreAll: materialize every device from the mapping
+    The snapshot file is dropped from the page cache before each open, so it is read from disk as on a reboot.
+
+    Build & run:
+        g++ -O2 -std=c++17 -pthread -I../moderncpp1 warm_restart_bench.cpp ../moderncpp1/device.cpp \
+            ../moderncpp1/device_registry.cpp ../moderncpp1/device_bitmap_index.cpp ../moderncpp1/device_snapshot.cpp \
+            ../moderncpp1/status_notifier.cpp ../moderncpp1/device_cold_store.cpp ../moderncpp1/lz_codec.cpp ../moderncpp1/string_interner.cpp && ./a.out [device_count]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "bench_util.h"
+#include "device_snapshot.h"
+
+static const std::size_t LOOKUPS = 1000;
+
+static long minorFaults()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF,&usage);
+    return usage.ru_minflt+usage.ru_majflt;
+}
+
+static void dropFromPageCache(const std::string& t_path)
+{
+    const int fd = ::open(t_path.c_str(),O_RDONLY);
+    if(fd<0)
+        return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+static void fill(DeviceRegistry& t_registry,std::size_t t_device_count)
+{
+    const BYTE payload[16]={'s','e','n','s','o','r',' ','r','e','a','d','i','n','g','s','\n'};
+    for(std::size_t i=0;i<t_device_count;++i)
+    {
+        DeviceHandle handle = t_registry.emplace(static_cast<DEVICE_TYPE>(i%DEVICE_TYPE_COUNT),
+                                                 static_cast<DEVICE_STATUS>(i%DEVICE_STATUS_COUNT),DEFAULT_BUFFER_CAPACITY);
+        t_registry.find(handle)->write_n(payload,i%sizeof(payload));
+    }
+}
+
+//save/reopen/restore of small snapshots (odd and even counts, with and without buffers, one explicit id),
+//compared with the saved devices: the bench only runs on a snapshot format that round-trips
+static bool roundTrip(const std::string& t_path)
+{
+    for(std::size_t count=0;count<=4;++count)
+        for(bool buffers:{false,true})
+        {
+            DeviceRegistry saved;
+            fill(saved,count);
+            if(count==3)
+                saved.emplace(Device::next_device_id.load()+100000,PRINTER,IDLE,DEFAULT_BUFFER_CAPACITY);
+            DeviceSnapshot::save(t_path,saved,buffers);
+
+            DeviceSnapshot snapshot(t_path);
+            DeviceRegistry restored;
+            snapshot.restoreAll(restored);
+            bool same = snapshot.size()==saved.size() && restored.size()==saved.size();
+            for(const Device& device:saved)
+            {
+                const Device* copy = restored.findById(device.getId());
+                if(copy==nullptr || copy->getTypeCode()!=device.getTypeCode() || copy->getStatusCode()!=device.getStatusCode()
+                   || device.getId()>=Device::next_device_id.load())
+                {
+                    same = false;
+                    continue;
+                }
+                BYTE saved_bytes[DEFAULT_BUFFER_CAPACITY],restored_bytes[DEFAULT_BUFFER_CAPACITY];
+                const DATA_SIZE saved_size = buffers ? device.peek_n(saved_bytes,sizeof(saved_bytes)) : 0;
+                const DATA_SIZE restored_size = copy->peek_n(restored_bytes,sizeof(restored_bytes));
+                same = same && saved_size==restored_size && std::memcmp(saved_bytes,restored_bytes,saved_size)==0;
+            }
+            if(!same)
+            {
+                std::fprintf(stderr,"snapshot round trip failed: %zu devices, buffers %d\n",count,buffers);
+                return false;
+            }
+        }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const std::size_t device_count = argc>1 ? std::strtoul(argv[1],nullptr,10) : 1000000;
+    const std::string path = "/tmp/warm_restart_bench.dsnp";
+    std::printf("%zu devices\n",device_count);
+    if(!roundTrip(path))
+        return 1;
+
+    int first_id = Device::next_device_id.load();
+    {
+        DeviceRegistry registry(device_count);
+        bench::Stopwatch watch;
+        fill(registry,device_count);
+        bench::report("constructors (cold start)",watch.elapsedNs(),device_count);
+
+        bench::Stopwatch save_watch;
+        DeviceSnapshot::save(path,registry,true);
+        bench::report("DeviceSnapshot::save (with buffers)",save_watch.elapsedNs(),device_count);
+    }
+    {
+        dropFromPageCache(path);
+        const long faults_before = minorFaults();
+        bench::Stopwatch watch;
+        DeviceSnapshot snapshot(path);
+        snapshot.adoptIdCounter();
+        std::size_t found = 0;
+        for(std::size_t i=0;i<LOOKUPS;++i)
+        {
+            const DeviceSnapshot::Record* record = snapshot.findById(first_id+static_cast<int>(i*7919%device_count));
+            found += record!=nullptr && record->getStatusCode()<DEVICE_STATUS_COUNT;
+        }
+        const double ns = watch.elapsedNs();
+        bench::doNotOptimize(found);
+        bench::report("snapshot open + "+std::to_string(LOOKUPS)+" lookups by id",ns,device_count);
+        std::printf("%-48s %12ld page faults, %zu found\n","",minorFaults()-faults_before,found);
+    }
+    {
+        dropFromPageCache(path);
+        DeviceRegistry registry(device_count);
+        bench::Stopwatch watch;
+        DeviceSnapshot snapshot(path);
+        snapshot.restoreAll(registry);
+        bench::report("snapshot restoreAll",watch.elapsedNs(),device_count);
+    }
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,356 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+//Per-operation latency histograms for the sample classes (device creation, moves, label lookups, buffer copies...).
+//Enabled at compile time with -DLATENCY_HISTOGRAMS=1 (CMake: -DSAMPLES_LATENCY_HISTOGRAMS=ON):
+//  LATENCY_SCOPE("name")   times the rest of the enclosing scope into the histogram of operation "name"
+//                          (compiles to nothing when LATENCY_HISTOGRAMS is 0, the default)
+//Every thread records into its own histograms: no lock and no shared cache line on the hot path.
+//latency::merged() adds the histograms of all threads on demand; latency::writeText/writeJson export
+//count, p50, p99, p99.9 and max of every operation. Histograms of finished threads are kept.
+//LATENCY_SCOPE may time noexcept functions (move constructors): registering an operation or a thread never
+//allocates and never throws.
+
+#ifndef LATENCY_HISTOGRAMS
+#define LATENCY_HISTOGRAMS 0
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace latency{
+
+//HDR-style log-linear buckets: exact below 64 ns, then 64 buckets per power of two, i.e. a value is known to
+//within 1/64 (1.6%) of itself up to about 18 minutes. Larger values land in the last bucket.
+class LatencyHistogram{
+public:
+    static const unsigned SUB_BUCKET_BITS = 6;
+    static const std::uint64_t SUB_BUCKETS = 1u<<SUB_BUCKET_BITS;
+    static const unsigned MAX_VALUE_BITS = 40;
+    static const std::size_t BUCKET_COUNT = (MAX_VALUE_BITS-SUB_BUCKET_BITS+1)*SUB_BUCKETS;
+
+    static std::size_t bucketOf(std::uint64_t t_value)
+    {
+        if(t_value<SUB_BUCKETS)
+            return static_cast<std::size_t>(t_value);
+        t_value = std::min<std::uint64_t>(t_value,(std::uint64_t{1}<<MAX_VALUE_BITS)-1);
+        //shift brings the value into [SUB_BUCKETS, 2*SUB_BUCKETS)
+        const unsigned shift = 63-static_cast<unsigned>(__builtin_clzll(t_value))-SUB_BUCKET_BITS;
+        return static_cast<std::size_t>((shift+1)*SUB_BUCKETS+((t_value>>shift)-SUB_BUCKETS));
+    }
+
+    //highest value that lands in t_bucket
+    static std::uint64_t bucketUpperBound(std::size_t t_bucket)
+    {
+        if(t_bucket<2*SUB_BUCKETS)
+            return t_bucket;
+        const unsigned shift = static_cast<unsigned>(t_bucket/SUB_BUCKETS-1);
+        const std::uint64_t sub_bucket = t_bucket%SUB_BUCKETS+SUB_BUCKETS;
+        return ((sub_bucket+1)<<shift)-1;
+    }
+
+    void record(std::uint64_t t_value)
+    {
+        ++m_counts[bucketOf(t_value)];
+        ++m_count;
+        m_sum += t_value;
+        m_max = std::max(m_max,t_value);
+    }
+
+    void addBucket(std::size_t t_bucket,std::uint64_t t_count)
+    {
+        m_counts[t_bucket] += t_count;
+        m_count += t_count;
+    }
+    void addTotals(std::uint64_t t_sum,std::uint64_t t_max)
+    {
+        m_sum += t_sum;
+        m_max = std::max(m_max,t_max);
+    }
+
+    void merge(const LatencyHistogram& t_other)
+    {
+        for(std::size_t i=0;i<BUCKET_COUNT;++i)
+            m_counts[i] += t_other.m_counts[i];
+        m_count += t_other.m_count;
+        addTotals(t_other.m_sum,t_other.m_max);
+    }
+
+    //smallest recorded value v such that t_percentile % of the values are <= v (within the bucket precision)
+    std::uint64_t valueAtPercentile(double t_percentile) const
+    {
+        if(m_count==0)
+            return 0;
+        const double wanted = t_percentile/100.0*static_cast<double>(m_count);
+        const std::uint64_t target = std::max<std::uint64_t>(1,static_cast<std::uint64_t>(wanted+0.999999));
+        std::uint64_t seen = 0;
+        for(std::size_t i=0;i<BUCKET_COUNT;++i)
+        {
+            seen += m_counts[i];
+            if(seen>=target)
+                return std::min(bucketUpperBound(i),m_max);
+        }
+        return m_max;
+    }
+
+    std::uint64_t count() const {return m_count;}
+    std::uint64_t max() const {return m_max;}
+    double mean() const {return m_count ? static_cast<double>(m_sum)/static_cast<double>(m_count) : 0.0;}
+
+private:
+    std::array<std::uint64_t,BUCKET_COUNT> m_counts{};
+    std::uint64_t m_count=0;
+    std::uint64_t m_sum=0;
+    std::uint64_t m_max=0;
+};
+
+//the histogram a thread records into: only its thread writes it, merged() reads it at any time
+//(relaxed atomics, plain loads and stores on x86: no read-modify-write on the hot path)
+class ThreadHistogram{
+public:
+    void record(std::uint64_t t_value)
+    {
+        bump(m_counts[LatencyHistogram::bucketOf(t_value)],1);
+        bump(m_sum,t_value);
+        if(t_value>m_max.load(std::memory_order_relaxed))
+            m_max.store(t_value,std::memory_order_relaxed);
+    }
+
+    void addTo(LatencyHistogram& t_histogram) const
+    {
+        for(std::size_t i=0;i<LatencyHistogram::BUCKET_COUNT;++i)
+            if(const std::uint64_t count = m_counts[i].load(std::memory_order_relaxed))
+                t_histogram.addBucket(i,count);
+        t_histogram.addTotals(m_sum.load(std::memory_order_relaxed),m_max.load(std::memory_order_relaxed));
+    }
+
+private:
+    static void bump(std::atomic<std::uint64_t>& t_counter,std::uint64_t t_value)
+    {
+        t_counter.store(t_counter.load(std::memory_order_relaxed)+t_value,std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>,LatencyHistogram::BUCKET_COUNT> m_counts{};
+    std::atomic<std::uint64_t> m_sum{0};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+typedef unsigned OperationId;
+
+//lock of the registry: registration runs inside noexcept functions, and unlike std::mutex::lock taking it
+//cannot throw. Only contended by registrations and merged(), never on the recording path.
+class SpinLock{
+public:
+    void lock() noexcept
+    {
+        while(m_flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    void unlock() noexcept {m_flag.clear(std::memory_order_release);}
+
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+};
+
+//Registry of the operations and of the per-thread histograms, in fixed storage: the names are the string
+//literals themselves and the threads are linked through their ThreadState
+class LatencyRegistry{
+public:
+    static const OperationId MAX_OPERATIONS = 32;
+
+    static LatencyRegistry& instance() noexcept
+    {
+        //never destroyed: threads may still record while static objects are destroyed
+        alignas(LatencyRegistry) static unsigned char storage[sizeof(LatencyRegistry)];
+        static LatencyRegistry* registry = new (storage) LatencyRegistry;
+        return *registry;
+    }
+
+    //id of the operation called t_name (a string literal), registered on first use
+    OperationId operation(const char* t_name) noexcept
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        for(OperationId id=0;id<m_operation_count;++id)
+            if(std::strcmp(m_names[id],t_name)==0)
+                return id;
+        if(m_operation_count==MAX_OPERATIONS)
+            return MAX_OPERATIONS;      //out of slots: not recorded
+        m_names[m_operation_count] = t_name;
+        return m_operation_count++;
+    }
+
+    void record(OperationId t_operation,std::uint64_t t_ns) noexcept
+    {
+        if(t_operation>=MAX_OPERATIONS)
+            return;
+        ThreadState& state = localState();
+        ThreadHistogram* histogram = state.histograms[t_operation].load(std::memory_order_relaxed);
+        if(histogram==nullptr)
+        {
+            //first sample of this operation on this thread; an allocation failure only loses the sample
+            histogram = new (std::nothrow) ThreadHistogram;
+            if(histogram==nullptr)
+                return;
+            state.histograms[t_operation].store(histogram,std::memory_order_release);
+        }
+        histogram->record(t_ns);
+    }
+
+    struct OperationHistogram{
+        std::string name;
+        LatencyHistogram histogram;
+    };
+
+    //the histograms of every thread, added up per operation (operations without samples are left out)
+    std::vector<OperationHistogram> merged()
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        std::vector<OperationHistogram> result;
+        for(OperationId id=0;id<m_operation_count;++id)
+        {
+            OperationHistogram operation{m_names[id],m_retired[id]};
+            for(const ThreadState* state=m_threads;state!=nullptr;state=state->next)
+                if(const ThreadHistogram* histogram = state->histograms[id].load(std::memory_order_acquire))
+                    histogram->addTo(operation.histogram);
+            if(operation.histogram.count())
+                result.push_back(std::move(operation));
+        }
+        return result;
+    }
+
+private:
+    struct ThreadState{
+        std::array<std::atomic<ThreadHistogram*>,MAX_OPERATIONS> histograms{};
+        ThreadState* previous=nullptr;      //list of the live threads, under m_lock
+        ThreadState* next=nullptr;
+
+        ThreadState() noexcept {LatencyRegistry::instance().attach(this);}
+        ~ThreadState(){LatencyRegistry::instance().detach(this);}
+    };
+
+    LatencyRegistry()=default;
+
+    static ThreadState& localState() noexcept
+    {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    void attach(ThreadState* t_state) noexcept
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        t_state->next = m_threads;
+        if(m_threads!=nullptr)
+            m_threads->previous = t_state;
+        m_threads = t_state;
+    }
+
+    //a finished thread: its samples are folded into m_retired
+    void detach(ThreadState* t_state)
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        for(OperationId id=0;id<MAX_OPERATIONS;++id)
+            if(ThreadHistogram* histogram = t_state->histograms[id].load(std::memory_order_relaxed))
+            {
+                histogram->addTo(m_retired[id]);
+                delete histogram;
+            }
+        (t_state->previous ? t_state->previous->next : m_threads) = t_state->next;
+        if(t_state->next!=nullptr)
+            t_state->next->previous = t_state->previous;
+    }
+
+    SpinLock m_lock;
+    std::array<const char*,MAX_OPERATIONS> m_names{};
+    OperationId m_operation_count=0;
+    ThreadState* m_threads=nullptr;
+    std::array<LatencyHistogram,MAX_OPERATIONS> m_retired{};
+};
+
+//records the time from its construction to its destruction
+class ScopedTimer{
+public:
+    explicit ScopedTimer(OperationId t_operation) noexcept:m_operation{t_operation},m_start{std::chrono::steady_clock::now()}{}
+    ScopedTimer(const ScopedTimer&)=delete;
+    ScopedTimer& operator=(const ScopedTimer&)=delete;
+    ~ScopedTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now()-m_start;
+        LatencyRegistry::instance().record(m_operation,static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+private:
+    OperationId m_operation;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+inline std::vector<LatencyRegistry::OperationHistogram> merged()
+{
+    return LatencyRegistry::instance().merged();
+}
+
+//one line per operation, latencies in nanoseconds
+inline void writeText(std::ostream& t_out)
+{
+    const auto operations = merged();
+    if(operations.empty())
+        return;
+    char line[160];
+    std::snprintf(line,sizeof(line),"%-32s %10s %10s %10s %10s %10s %12s\n","operation (ns)","count","mean","p50","p99","p99.9","max");
+    t_out<<line;
+    for(const auto& operation:operations)
+    {
+        const LatencyHistogram& histogram = operation.histogram;
+        std::snprintf(line,sizeof(line),"%-32s %10llu %10.1f %10llu %10llu %10llu %12llu\n",operation.name.c_str(),
+                      static_cast<unsigned long long>(histogram.count()),histogram.mean(),
+                      static_cast<unsigned long long>(histogram.valueAtPercentile(50)),
+                      static_cast<unsigned long long>(histogram.valueAtPercentile(99)),
+                      static_cast<unsigned long long>(histogram.valueAtPercentile(99.9)),
+                      static_cast<unsigned long long>(histogram.max()));
+        t_out<<line;
+    }
+}
+
+//{"operations":[{"name":...,"count":...,"mean_ns":...,"p50_ns":...,"p99_ns":...,"p999_ns":...,"max_ns":...},...]}
+//operation names are string literals of the code base: no escaping needed
+inline void writeJson(std::ostream& t_out)
+{
+    t_out<<"{\"operations\":[";
+    const char* separator = "";
+    for(const auto& operation:merged())
+    {
+        const LatencyHistogram& histogram = operation.histogram;
+        t_out<<separator<<"{\"name\":\""<<operation.name<<"\",\"count\":"<<histogram.count()
+             <<",\"mean_ns\":"<<histogram.mean()
+             <<",\"p50_ns\":"<<histogram.valueAtPercentile(50)
+             <<",\"p99_ns\":"<<histogram.valueAtPercentile(99)
+             <<",\"p999_ns\":"<<histogram.valueAtPercentile(99.9)
+             <<",\"max_ns\":"<<histogram.max()<<"}";
+        separator = ",";
+    }
+    t_out<<"]}\n";
+}
+
+}
+
+#if LATENCY_HISTOGRAMS
+#define LATENCY_SCOPE(t_name) \
+    static const ::latency::OperationId latency_operation_ = ::latency::LatencyRegistry::instance().operation("" t_name); \
+    ::latency::ScopedTimer latency_timer_(latency_operation_)
+#else
+#define LATENCY_SCOPE(t_name) ((void)0)
+#endif
+
+#endif // LATENCY_HISTOGRAM_H
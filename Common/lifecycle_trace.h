@@ -0,0 +1,147 @@
+#ifndef LIFECYCLE_TRACE_H
+#define LIFECYCLE_TRACE_H
+
+//Tracepoints for constructors, assignments and destructors of the sample classes.
+//The cost is chosen at compile time with LIFECYCLE_TRACE_MODE (e.g. -DLIFECYCLE_TRACE_MODE=LIFECYCLE_TRACE_RING):
+//  LIFECYCLE_TRACE_OFF     tracepoints compile to nothing
+//  LIFECYCLE_TRACE_RING    a fixed-size binary event (timestamp, object, message pointer) goes into a per-thread
+//                          ring of the last LIFECYCLE_TRACE_RING_SIZE events, printed on demand by lifecycle::dump()
+//  LIFECYCLE_TRACE_STDOUT  the message is printed to std::cout right away (default, the samples' console output)
+//Messages must be string literals: the ring stores the pointer only.
+
+#define LIFECYCLE_TRACE_OFF 0
+#define LIFECYCLE_TRACE_RING 1
+#define LIFECYCLE_TRACE_STDOUT 2
+
+#ifndef LIFECYCLE_TRACE_MODE
+#define LIFECYCLE_TRACE_MODE LIFECYCLE_TRACE_STDOUT
+#endif
+
+#ifndef LIFECYCLE_TRACE_RING_SIZE
+#define LIFECYCLE_TRACE_RING_SIZE 4096
+#endif
+
+#include <iostream>
+
+#if LIFECYCLE_TRACE_MODE==LIFECYCLE_TRACE_RING
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace lifecycle{
+
+#if LIFECYCLE_TRACE_MODE==LIFECYCLE_TRACE_RING
+
+struct TraceEvent{
+    std::uint64_t timestamp_ns;
+    const void* object;
+    const char* message;
+};
+
+//written only by its own thread; kept alive by the registry after the thread exits, so its events can still be dumped
+class TraceRing{
+public:
+    static const std::size_t CAPACITY = LIFECYCLE_TRACE_RING_SIZE;
+    static_assert((CAPACITY&(CAPACITY-1))==0,"LIFECYCLE_TRACE_RING_SIZE must be a power of two");
+
+    explicit TraceRing(unsigned t_thread_index):m_thread_index{t_thread_index}{}
+
+    void record(const void* t_object,const char* t_message)
+    {
+        const std::uint64_t now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        m_events[m_count&(CAPACITY-1)] = TraceEvent{now,t_object,t_message};
+        ++m_count;
+    }
+
+    //oldest event first
+    void dump(std::ostream& t_out) const
+    {
+        const std::uint64_t first = m_count>CAPACITY ? m_count-CAPACITY : 0;
+        if(first)
+            t_out<<"[thread "<<m_thread_index<<"] "<<first<<" older events overwritten\n";
+        for(std::uint64_t i=first;i<m_count;++i)
+        {
+            const TraceEvent& event = m_events[i&(CAPACITY-1)];
+            t_out<<"[thread "<<m_thread_index<<"] "<<event.timestamp_ns<<" ns "<<event.object<<" "<<event.message<<"\n";
+        }
+    }
+
+    void clear(){m_count=0;}
+
+private:
+    unsigned m_thread_index;
+    std::uint64_t m_count=0;
+    std::array<TraceEvent,CAPACITY> m_events;
+};
+
+class TraceRegistry{
+public:
+    static TraceRegistry& instance()
+    {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<TraceRing> createRing()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rings.push_back(std::make_shared<TraceRing>(static_cast<unsigned>(m_rings.size())));
+        return m_rings.back();
+    }
+
+    //other threads must not be tracing meanwhile
+    void dump(std::ostream& t_out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(const auto& ring:m_rings)
+            ring->dump(t_out);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<TraceRing>> m_rings;
+};
+
+//the calling thread's ring, registered on first use
+inline TraceRing& localRing()
+{
+    thread_local std::shared_ptr<TraceRing> ring = TraceRegistry::instance().createRing();
+    return *ring;
+}
+
+inline void trace(const void* t_object,const char* t_message)
+{
+    localRing().record(t_object,t_message);
+}
+
+//prints the events of every thread that traced so far
+inline void dump(std::ostream& t_out=std::cout)
+{
+    TraceRegistry::instance().dump(t_out);
+}
+
+#else
+
+//nothing is buffered in the other modes
+inline void dump(std::ostream& =std::cout){}
+
+#endif
+
+}
+
+#if LIFECYCLE_TRACE_MODE==LIFECYCLE_TRACE_OFF
+#define LIFECYCLE_TRACE(t_object,t_message) ((void)0)
+#elif LIFECYCLE_TRACE_MODE==LIFECYCLE_TRACE_RING
+#define LIFECYCLE_TRACE(t_object,t_message) ::lifecycle::trace((t_object),("" t_message))
+#elif LIFECYCLE_TRACE_MODE==LIFECYCLE_TRACE_STDOUT
+#define LIFECYCLE_TRACE(t_object,t_message) (std::cout<<("" t_message)<<std::endl)
+#else
+#error "LIFECYCLE_TRACE_MODE must be LIFECYCLE_TRACE_OFF, LIFECYCLE_TRACE_RING or LIFECYCLE_TRACE_STDOUT"
+#endif
+
+#endif // LIFECYCLE_TRACE_H
@@ -0,0 +1,385 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<mutex>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<system_error>
+#include<thread>
+#include<vector>
+#include<cerrno>
+#include<fcntl.h>
+#include<unistd.h>
+#include "Logger.h"
+#include "LogFormat.h"
+
+//What to do when a producer thread finds its queue full
+enum class OverflowPolicy{
+	Block,	//wait until the writer thread made room (no record is ever lost)
+	Drop,	//discard the record, only droppedRecords() tells about it
+	Count	//discard the record and let the writer print how many records were dropped
+};
+
+struct AsyncLogOptions{
+	std::size_t queue_capacity=1024;	//records per producer thread (rounded up to a power of two)
+	std::size_t batch_bytes=64*1024;	//bytes collected before a write() call
+	OverflowPolicy overflow=OverflowPolicy::Block;
+};
+
+//Asynchronous logging backend: the calling thread only copies the message into its own lock-free
+//single-producer/single-consumer queue; a background writer thread drains all queues and writes the
+//records in large batches with write(2). No terminal or file I/O ever happens on the caller's thread.
+//When every queue is empty the writer sleeps on a condition variable: a producer only takes its mutex
+//to wake it up, when the writer flagged itself asleep.
+//Records are fixed-size, messages longer than RECORD_TEXT_SIZE bytes are truncated.
+class AsyncLogBackend{
+	public:
+		static constexpr std::size_t RECORD_TEXT_SIZE = 248;
+
+		typedef AsyncLogOptions Options;
+
+		//logs to an already open file descriptor (not closed by the backend), e.g. STDOUT_FILENO
+		explicit AsyncLogBackend(int t_fd=STDOUT_FILENO,Options t_options=Options{})
+			:m_fd{t_fd},m_owns_fd{false},m_options{t_options}
+		{
+			start();
+		}
+
+		//logs to a file, appending to it
+		explicit AsyncLogBackend(const std::string& t_path,Options t_options=Options{})
+			:m_fd{::open(t_path.c_str(),O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC,0644)},m_owns_fd{true},m_options{t_options}
+		{
+			if(m_fd<0)
+				throw std::system_error(errno,std::generic_category(),"AsyncLogBackend: cannot open "+t_path);
+			start();
+		}
+
+		AsyncLogBackend(const AsyncLogBackend&)=delete;
+		AsyncLogBackend& operator=(const AsyncLogBackend&)=delete;
+
+		//writes every queued record before returning
+		~AsyncLogBackend()
+		{
+			m_stop.store(true,std::memory_order_release);
+			wakeWriter();
+			m_writer.join();
+			for(auto& queue:m_queues)
+				queue->backend_destroyed.store(true,std::memory_order_release);
+			if(m_owns_fd)
+				::close(m_fd);
+		}
+
+		//hot path: one copy into the calling thread's queue, returns false if the record was dropped
+		bool log(std::string_view t_message)
+		{
+			return logWith([t_message](char* t_out,std::size_t t_capacity){
+				const std::size_t length = std::min(t_message.size(),t_capacity);
+				std::memcpy(t_out,t_message.data(),length);
+				return length;
+			});
+		}
+
+		//formats straight into the queued record: t_format(char* out, std::size_t capacity) returns the length written
+		template<typename Formatter>
+		bool logWith(Formatter&& t_format)
+		{
+			ThreadQueue& queue = localQueue();
+			const std::uint64_t head = queue.head.load(std::memory_order_relaxed);
+			if(head-queue.cached_tail==queue.capacity)
+			{
+				queue.cached_tail = queue.tail.load(std::memory_order_acquire);
+				while(head-queue.cached_tail==queue.capacity)
+				{
+					if(m_options.overflow!=OverflowPolicy::Block)
+					{
+						queue.dropped.fetch_add(1,std::memory_order_relaxed);
+						return false;
+					}
+					std::this_thread::yield();
+					queue.cached_tail = queue.tail.load(std::memory_order_acquire);
+				}
+			}
+			Record& record = queue.records[head&(queue.capacity-1)];
+			record.length = static_cast<std::uint32_t>(std::min<std::size_t>(t_format(record.text,RECORD_TEXT_SIZE),RECORD_TEXT_SIZE));
+			//seq_cst pairs with the writer flagging itself asleep before it checks the queues a last time
+			queue.head.store(head+1,std::memory_order_seq_cst);
+			if(m_writer_sleeping.load(std::memory_order_seq_cst))
+				wakeWriter();
+			return true;
+		}
+
+		//blocks until every record logged before this call has been handed to the operating system
+		void flush()
+		{
+			std::vector<std::pair<std::shared_ptr<ThreadQueue>,std::uint64_t>> targets;
+			{
+				std::lock_guard<std::mutex> lock(m_queues_mutex);
+				for(auto& queue:m_queues)
+					targets.emplace_back(queue,queue->head.load(std::memory_order_acquire));
+			}
+			for(auto& target:targets)
+				while(target.first->written.load(std::memory_order_acquire)<target.second)
+					std::this_thread::yield();
+		}
+
+		std::uint64_t droppedRecords() const
+		{
+			std::lock_guard<std::mutex> lock(m_queues_mutex);
+			std::uint64_t total = m_retired_dropped;
+			for(auto& queue:m_queues)
+				total += queue->dropped.load(std::memory_order_relaxed);
+			return total;
+		}
+
+	private:
+		struct Record{
+			std::uint32_t length;
+			char text[RECORD_TEXT_SIZE];
+		};
+
+		//one queue per producer thread: head is written by the producer, tail by the writer thread.
+		//Shared by the backend and the thread: each side flags when it is gone, so the other one can drop it.
+		struct ThreadQueue{
+			explicit ThreadQueue(std::size_t t_capacity):capacity{t_capacity},records{new Record[t_capacity]}{}
+
+			const std::size_t capacity;
+			std::unique_ptr<Record[]> records;
+			alignas(64) std::atomic<std::uint64_t> head{0};
+			std::uint64_t cached_tail=0;
+			std::atomic<std::uint64_t> dropped{0};
+			alignas(64) std::atomic<std::uint64_t> tail{0};
+			std::atomic<std::uint64_t> written{0};	//records handed to write(), used by flush()
+			std::atomic<bool> thread_exited{false};	//no more records: the writer drops it once drained
+			std::atomic<bool> backend_destroyed{false};	//the thread drops it when it needs a new queue, or at exit
+		};
+
+		void start()
+		{
+			std::size_t capacity = 1;
+			while(capacity<m_options.queue_capacity)
+				capacity <<= 1;
+			m_options.queue_capacity = capacity;
+			m_batch.reserve(m_options.batch_bytes+RECORD_TEXT_SIZE+1);
+			m_writer = std::thread([this]{writerLoop();});
+		}
+
+		//the calling thread's queue for this backend, registered on first use
+		ThreadQueue& localQueue()
+		{
+			//keyed by a never reused id (not the address), so a new backend at the address of a dead one is not confused with it.
+			//At thread exit every queue is flagged, the writers drop them once they are drained.
+			struct Entries{
+				std::vector<std::pair<std::uint64_t,std::shared_ptr<ThreadQueue>>> list;
+				~Entries()
+				{
+					for(auto& entry:list)
+						entry.second->thread_exited.store(true,std::memory_order_release);
+				}
+			};
+			thread_local Entries local_queues;
+			for(auto& entry:local_queues.list)
+				if(entry.first==m_id)
+					return *entry.second;
+
+			//the queues of destroyed backends are only dropped here, a thread that logs keeps no dead queues around
+			auto& list = local_queues.list;
+			list.erase(std::remove_if(list.begin(),list.end(),[](const auto& t_entry){
+				return t_entry.second->backend_destroyed.load(std::memory_order_acquire);}),list.end());
+			auto queue = std::make_shared<ThreadQueue>(m_options.queue_capacity);
+			{
+				std::lock_guard<std::mutex> lock(m_queues_mutex);
+				m_queues.push_back(queue);
+				m_queues_version.fetch_add(1,std::memory_order_seq_cst);
+			}
+			list.emplace_back(m_id,queue);
+			return *queue;
+		}
+
+		void writerLoop()
+		{
+			std::vector<std::shared_ptr<ThreadQueue>> queues;
+			std::vector<ThreadQueue*> exited;
+			std::uint64_t queues_version = 0;
+			std::uint64_t reported_drops = 0;
+			for(;;)
+			{
+				//stop is read before draining, so records queued before the destructor ran are all written
+				const bool stopping = m_stop.load(std::memory_order_acquire);
+				const std::uint64_t version = m_queues_version.load(std::memory_order_acquire);
+				if(queues_version!=version)
+				{
+					std::lock_guard<std::mutex> lock(m_queues_mutex);
+					queues = m_queues;
+					queues_version = version;
+				}
+
+				bool drained_any = false;
+				std::uint64_t drops = m_retired_dropped;
+				for(auto& queue:queues)
+				{
+					//read before draining: an exited thread queued nothing after it, the queue is empty afterwards
+					if(queue->thread_exited.load(std::memory_order_acquire))
+						exited.push_back(queue.get());
+					drained_any |= drain(*queue);
+					drops += queue->dropped.load(std::memory_order_relaxed);
+				}
+				if(m_options.overflow==OverflowPolicy::Count && drops!=reported_drops)
+				{
+					appendText("[AsyncLogBackend] "+std::to_string(drops-reported_drops)+" records dropped\n");
+					reported_drops = drops;
+				}
+				writeBatch();
+				if(!exited.empty())
+				{
+					dropQueues(exited);
+					exited.clear();
+				}
+
+				if(!drained_any)
+				{
+					if(stopping)
+						return;
+					waitForRecords(queues,queues_version);
+				}
+			}
+		}
+
+		//the drained queues of exited threads, their drop count is kept for droppedRecords()
+		void dropQueues(const std::vector<ThreadQueue*>& t_exited)
+		{
+			std::lock_guard<std::mutex> lock(m_queues_mutex);
+			m_queues.erase(std::remove_if(m_queues.begin(),m_queues.end(),[&](const std::shared_ptr<ThreadQueue>& t_queue){
+				if(std::find(t_exited.begin(),t_exited.end(),t_queue.get())==t_exited.end())
+					return false;
+				m_retired_dropped += t_queue->dropped.load(std::memory_order_relaxed);
+				return true;
+			}),m_queues.end());
+			m_queues_version.fetch_add(1,std::memory_order_seq_cst);
+		}
+
+		//sleeps until a producer queues a record or the backend is destroyed. The flag is set before the queues
+		//are checked a last time (both seq_cst): a producer either sees the flag or its record is seen here.
+		void waitForRecords(const std::vector<std::shared_ptr<ThreadQueue>>& t_queues,std::uint64_t t_version)
+		{
+			m_writer_sleeping.store(true,std::memory_order_seq_cst);
+			bool empty = m_queues_version.load(std::memory_order_seq_cst)==t_version;
+			for(auto& queue:t_queues)
+				empty = empty && queue->head.load(std::memory_order_seq_cst)==queue->tail.load(std::memory_order_relaxed);
+			if(empty)
+			{
+				std::unique_lock<std::mutex> lock(m_wake_mutex);
+				m_wake_cv.wait(lock,[this]{return m_wake_pending;});
+				m_wake_pending = false;
+			}
+			m_writer_sleeping.store(false,std::memory_order_relaxed);
+		}
+
+		void wakeWriter()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_wake_mutex);
+				m_wake_pending = true;
+			}
+			m_wake_cv.notify_one();
+		}
+
+		//moves the queued records into the batch, writing the batch out whenever it is full
+		bool drain(ThreadQueue& t_queue)
+		{
+			std::uint64_t tail = t_queue.tail.load(std::memory_order_relaxed);
+			const std::uint64_t head = t_queue.head.load(std::memory_order_acquire);
+			if(tail==head)
+				return false;
+			for(;tail!=head;++tail)
+			{
+				const Record& record = t_queue.records[tail&(t_queue.capacity-1)];
+				m_batch.insert(m_batch.end(),record.text,record.text+record.length);
+				m_batch.push_back('\n');
+				if(m_batch.size()>=m_options.batch_bytes)
+				{
+					t_queue.tail.store(tail+1,std::memory_order_release);
+					m_pending.emplace_back(&t_queue,tail+1);
+					writeBatch();
+				}
+			}
+			t_queue.tail.store(tail,std::memory_order_release);
+			m_pending.emplace_back(&t_queue,tail);
+			return true;
+		}
+
+		void appendText(const std::string& t_text)
+		{
+			m_batch.insert(m_batch.end(),t_text.begin(),t_text.end());
+		}
+
+		//one write() for the whole batch (more if the OS accepts it partially), then publish progress for flush()
+		void writeBatch()
+		{
+			std::size_t offset = 0;
+			while(offset<m_batch.size())
+			{
+				const ssize_t n = ::write(m_fd,m_batch.data()+offset,m_batch.size()-offset);
+				if(n<0 && errno==EINTR)
+					continue;
+				if(n<=0)
+					break;	//nothing sensible to do when the log target itself fails: drop the batch
+				offset += static_cast<std::size_t>(n);
+			}
+			m_batch.clear();
+			for(auto& pending:m_pending)
+				pending.first->written.store(pending.second,std::memory_order_release);
+			m_pending.clear();
+		}
+
+		static std::uint64_t nextId()
+		{
+			static std::atomic<std::uint64_t> next_id{1};
+			return next_id.fetch_add(1,std::memory_order_relaxed);
+		}
+
+		const std::uint64_t m_id=nextId();
+		int m_fd;
+		bool m_owns_fd;
+		Options m_options;
+
+		mutable std::mutex m_queues_mutex;	//taken only when a thread registers its queue or the writer drops one
+		std::vector<std::shared_ptr<ThreadQueue>> m_queues;
+		std::atomic<std::uint64_t> m_queues_version{0};	//bumped on every change of m_queues
+		std::uint64_t m_retired_dropped=0;	//dropped by the queues of exited threads
+
+		//the writer sleeps on m_wake_cv when every queue is empty
+		std::atomic<bool> m_writer_sleeping{false};
+		std::mutex m_wake_mutex;
+		std::condition_variable m_wake_cv;
+		bool m_wake_pending=false;
+
+		//writer thread state
+		std::vector<char> m_batch;
+		std::vector<std::pair<ThreadQueue*,std::uint64_t>> m_pending;
+		std::atomic<bool> m_stop{false};
+		std::thread m_writer;
+};
+
+//Filters first, then formats the decorated message directly into the queued record:
+//a record below the threshold costs one comparison, a logged one no allocation
+template<typename Format>
+bool logAsync(AsyncLogBackend& t_backend,const StaticLogger<Format>& t_logger,LogLevel t_level)
+{
+	if(!t_logger.enabled(t_level))
+		return false;
+	return t_backend.logWith([&](char* t_out,std::size_t t_capacity){
+		FormatBuffer buffer(t_out,t_capacity);
+		t_logger.formatTo(buffer,t_level);
+		return buffer.size();
+	});
+}
+
+#endif // ASYNCLOGGER_H
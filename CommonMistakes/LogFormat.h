@@ -0,0 +1,124 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include<algorithm>
+#include<cstddef>
+#include<cstring>
+#include<string>
+#include<string_view>
+#include<utility>
+
+//Lazy, allocation-free alternative to the virtual getMessage() of Logger.h:
+//	- decorators are template layers combined at compile time (Decorated<LevelTag<>>): no virtual call, no heap
+//	- a message is formatted only when its level passes the logger threshold
+//	- formatting goes straight into a caller supplied buffer (or a thread local one), never into a new std::string
+
+enum class LogLevel{Debug=0,Info,Warning,Error};
+
+inline std::string_view levelLabel(LogLevel t_level)
+{
+	switch(t_level)
+	{
+		case LogLevel::Debug: return "DEBUG";
+		case LogLevel::Info: return "INFO";
+		case LogLevel::Warning: return "WARNING";
+		case LogLevel::Error: return "ERROR";
+	}
+	return "?";
+}
+
+//Fixed-capacity output over memory owned by someone else: appends past the capacity are truncated
+class FormatBuffer{
+	public:
+		FormatBuffer(char* t_data,std::size_t t_capacity):m_data{t_data},m_capacity{t_capacity}{}
+
+		FormatBuffer& append(std::string_view t_text)
+		{
+			const std::size_t length = std::min(t_text.size(),m_capacity-m_size);
+			std::memcpy(m_data+m_size,t_text.data(),length);
+			m_size += length;
+			return *this;
+		}
+
+		std::size_t size() const {return m_size;}
+		std::size_t capacity() const {return m_capacity;}
+		bool truncated() const {return m_size==m_capacity;}
+		std::string_view view() const {return std::string_view(m_data,m_size);}
+		void clear(){m_size=0;}
+
+		//a per-thread scratch buffer, reused by every call on the same thread
+		static FormatBuffer threadLocal()
+		{
+			thread_local char storage[1024];
+			return FormatBuffer(storage,sizeof(storage));
+		}
+
+	private:
+		char* m_data;
+		std::size_t m_capacity;
+		std::size_t m_size=0;
+};
+
+//Decorator layers: each one is a type with a static format(out, level, message) calling its inner layer.
+//Stacking is resolved by the compiler and inlined, e.g. LevelTag<Decorated<>> gives "[INFO] Decorated Log Message: (...)".
+struct PlainMessage{
+	static void format(FormatBuffer& t_out,LogLevel,std::string_view t_msg){t_out.append(t_msg);}
+};
+
+//same decoration as MyLogger::getMessage()
+template<typename Inner=PlainMessage>
+struct Decorated{
+	static void format(FormatBuffer& t_out,LogLevel t_level,std::string_view t_msg)
+	{
+		t_out.append("Decorated Log Message: (");
+		Inner::format(t_out,t_level,t_msg);
+		t_out.append(")");
+	}
+};
+
+template<typename Inner=PlainMessage>
+struct LevelTag{
+	static void format(FormatBuffer& t_out,LogLevel t_level,std::string_view t_msg)
+	{
+		t_out.append("[").append(levelLabel(t_level)).append("] ");
+		Inner::format(t_out,t_level,t_msg);
+	}
+};
+
+//Logger whose decoration is the compile-time layer stack Format (counterpart of BaseLogger/MyLogger)
+template<typename Format=PlainMessage>
+class StaticLogger{
+	public:
+		explicit StaticLogger(std::string t_msg,LogLevel t_threshold=LogLevel::Info)
+			:m_msg{std::move(t_msg)},m_threshold{t_threshold}{}
+
+		bool enabled(LogLevel t_level) const {return t_level>=m_threshold;}
+		void setThreshold(LogLevel t_level){m_threshold=t_level;}
+		void setMessage(std::string t_msg){m_msg=std::move(t_msg);}
+
+		//formats into t_out only if t_level passes the threshold; nothing is formatted otherwise
+		bool formatTo(FormatBuffer& t_out,LogLevel t_level) const
+		{
+			if(!enabled(t_level))
+				return false;
+			Format::format(t_out,t_level,m_msg);
+			return true;
+		}
+
+		//formats into the thread local buffer, the view stays valid until the next use of that buffer on this thread
+		std::string_view format(LogLevel t_level) const
+		{
+			FormatBuffer buffer = FormatBuffer::threadLocal();
+			formatTo(buffer,t_level);
+			return buffer.view();
+		}
+
+	private:
+		std::string m_msg;
+		LogLevel m_threshold;
+};
+
+//compile-time equivalent of MyLogger
+typedef StaticLogger<Decorated<>> MyStaticLogger;
+
+#endif // LOGFORMAT_H
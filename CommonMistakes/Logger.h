@@ -0,0 +1,53 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include<algorithm>
+#include<cstddef>
+#include<cstring>
+#include<string>
+#include<string_view>
+#include<utility>
+
+class BaseLogger{
+	public:
+		//the message is taken by value and moved into place: callers passing a temporary pay no copy at all
+		BaseLogger(std::string t_msg="BASE LOGGER INITIALIZED"):m_msg{std::move(t_msg)}{}
+		
+		//const identifier is used to avoid compiler error when using const object reference
+		//this identifier tells the compiler that this method will not make any change to the object data
+		virtual std::string getMessage() const {return m_msg;}
+
+		//same message, copied into t_out without allocating: returns the length (at most t_capacity)
+		virtual std::size_t copyMessage(char* t_out,std::size_t t_capacity) const {return append(t_out,t_capacity,0,m_msg);}
+		
+		void setMessage(std::string t_msg){m_msg=std::move(t_msg);}
+	protected:
+		//appends t_text after the first t_size bytes of t_out, as much of it as fits
+		static std::size_t append(char* t_out,std::size_t t_capacity,std::size_t t_size,std::string_view t_text)
+		{
+			const std::size_t length = std::min(t_text.size(),t_capacity-t_size);
+			std::memcpy(t_out+t_size,t_text.data(),length);
+			return t_size+length;
+		}
+
+		std::string m_msg;
+};
+
+class MyLogger : public BaseLogger{
+	public:
+		//Using Parent Class Construtor
+		MyLogger(std::string t_msg):BaseLogger(std::move(t_msg)){}
+		
+		//const identifier is used to avoid compiler error when using const object reference
+		//this identifier tells the compiler that this method will not make any change to the object data
+		virtual std::string getMessage() const override{
+			return std::string("Decorated Log Message: ") + "(" + m_msg + ")";
+		}
+
+		virtual std::size_t copyMessage(char* t_out,std::size_t t_capacity) const override{
+			const std::size_t size = append(t_out,t_capacity,0,"Decorated Log Message: (");
+			return append(t_out,t_capacity,append(t_out,t_capacity,size,m_msg),")");
+		}
+};
+
+#endif // LOGGER_H
@@ -1,5 +1,7 @@
 #include<iostream>
 #include<string>
+#include "Logger.h"
+#include "AsyncLogger.h"
 
 /**
  * This simple example demonstrate avoid Object Slicing and how to avoid it using call by reference
@@ -8,43 +10,34 @@
  * 		In C++ programming, object slicing occurs when an object of a subclass type is copied to an object
  * 		of superclass type: the superclass copy will not have any of the member variables defined in the subclass.
  * 		These variables have, in effect, been "sliced off". 
+ *
+ * BaseLogger and MyLogger are defined in Logger.h. The log functions below queue their records to the
+ * asynchronous backend of AsyncLogger.h (no I/O on the caller's thread), LogFormat.h adds compile-time
+ * decorators formatting without virtual calls or allocations.
+ * Build: g++ -std=c++17 -pthread object_slicing.cpp
  */
 
-class BaseLogger{
-	public:
-		BaseLogger(std::string t_msg="BASE LOGGER INITIALIZED"):m_msg{t_msg}{}
-		
-		//const identifier is used to avoid compiler error when using const object reference
-		//this identifier tells the compiler that this method will not make any change to the object data
-		virtual std::string getMessage() const {return m_msg;}
-		
-		void setMessage(std::string t_msg){m_msg=t_msg;}
-	protected:
-		std::string m_msg;
-};
-
-class MyLogger : public BaseLogger{
-	public:
-		//Using Parent Class Construtor
-		MyLogger(std::string t_msg):BaseLogger(t_msg){}
-		
-		//const identifier is used to avoid compiler error when using const object reference
-		//this identifier tells the compiler that this method will not make any change to the object data
-		virtual std::string getMessage() const override{
-			return std::string("Decorated Log Message: ") + "(" + m_msg + ")";
-		}
-};
+//the caller only pays for an enqueue: t_prefix and the message are copied straight into the queued record
+//(no std::string is built), the backend thread does the I/O
+void writeLog(AsyncLogBackend& backend,const char* t_prefix,const BaseLogger& logger)
+{
+	backend.logWith([&](char* t_out,std::size_t t_capacity){
+		FormatBuffer buffer(t_out,t_capacity);
+		buffer.append(t_prefix);
+		return buffer.size()+logger.copyMessage(t_out+buffer.size(),t_capacity-buffer.size());
+	});
+}
 
 //Call function by Value will cause object slicing to the input argument
-void writeLogByVal(BaseLogger logger)
+void writeLogByVal(AsyncLogBackend& backend,BaseLogger logger)
 {
-	std::cout<<"writeLogByVal - This will write to log file: \n"<<logger.getMessage()<<std::endl;
+	writeLog(backend,"writeLogByVal - This will write to log file: \n",logger);
 }
 
 //avoid Object Slicing using object Reference
-void writeLogByRef(const BaseLogger& logger)
+void writeLogByRef(AsyncLogBackend& backend,const BaseLogger& logger)
 {
-	std::cout<<"writeLogByRef - This will write to log file: \n"<<logger.getMessage()<<std::endl;
+	writeLog(backend,"writeLogByRef - This will write to log file: \n",logger);
 }
 
 int main()
@@ -53,7 +46,18 @@ int main()
 	std::cout<<"base_logger message: \n"<<base_logger.getMessage()<<std::endl;
 	MyLogger mylogger("Preparing Logger");
 	std::cout<<"mylogger message: \n"<<mylogger.getMessage()<<std::endl;
-	writeLogByVal(mylogger);
-	writeLogByRef(mylogger);
+
+	//from here on the records are written by the backend thread
+	std::cout.flush();
+	AsyncLogBackend backend(STDOUT_FILENO);
+	writeLogByVal(backend,mylogger);
+	writeLogByRef(backend,mylogger);
+	writeLogByRef(backend,base_logger);
+
+	//compile-time decorators: formatted lazily, straight into the queued record, only when the level passes
+	StaticLogger<LevelTag<Decorated<>>> static_logger("Preparing Logger",LogLevel::Info);
+	logAsync(backend,static_logger,LogLevel::Debug);	//filtered out: never formatted
+	logAsync(backend,static_logger,LogLevel::Warning);
+	backend.flush();
 	return 0;
 }
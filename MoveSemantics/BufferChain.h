@@ -0,0 +1,121 @@
+#ifndef BUFFERCHAIN_H
+#define BUFFERCHAIN_H
+
+#include<memory_resource>
+#include<vector>
+#include<sys/uio.h>
+#include "DataBuffer.h"
+
+//Rope / segment chain: a message made of several DataBuffers without copying them into one block.
+//Appending takes ownership of the moved-in buffer (or shares a copied one through copy-on-write),
+//so assembling a message from N chunks costs O(N), independent of the number of bytes.
+//Bytes are only copied by flatten(), when a caller really needs one contiguous block.
+class BufferChain{
+	public:
+		explicit BufferChain(std::pmr::memory_resource* t_resource=std::pmr::get_default_resource()):m_segments{t_resource}{}
+
+		BufferChain& append(DataBuffer&& t_segment)
+		{
+			if(t_segment.size()>0)
+			{
+				m_size += t_segment.size();
+				m_segments.push_back(std::move(t_segment));
+			}
+			return *this;
+		}
+
+		//an lvalue segment is shared, not copied (see DataBuffer copy-on-write)
+		BufferChain& append(const DataBuffer& t_segment)
+		{
+			return append(DataBuffer(t_segment));
+		}
+
+		void reserve(std::size_t t_segment_count){m_segments.reserve(t_segment_count);}
+		void clear(){m_segments.clear();m_size=0;}
+
+		//total number of bytes in the chain
+		std::size_t size() const {return m_size;}
+		std::size_t segmentCount() const {return m_segments.size();}
+		bool isContiguous() const {return m_segments.size()<=1;}
+
+		//scatter/gather iteration: range-based for over the segments, each one exposes getData() and size()
+		std::pmr::vector<DataBuffer>::const_iterator begin() const {return m_segments.begin();}
+		std::pmr::vector<DataBuffer>::const_iterator end() const {return m_segments.end();}
+
+		//fills up to t_max iovec entries for writev()/sendmsg(), returns the number of entries used
+		std::size_t fillIoVec(iovec* t_iov,std::size_t t_max) const
+		{
+			std::size_t count = 0;
+			for(const DataBuffer& segment:m_segments)
+			{
+				if(count==t_max)
+					break;
+				t_iov[count].iov_base = const_cast<Byte*>(segment.getData());
+				t_iov[count].iov_len = segment.size();
+				++count;
+			}
+			return count;
+		}
+
+		//copies the bytes into t_out (which must hold size() bytes)
+		void copyTo(Byte* t_out) const
+		{
+			for(const DataBuffer& segment:m_segments)
+				t_out = std::copy(segment.getData(),segment.getData()+segment.size(),t_out);
+		}
+
+		//one contiguous buffer: a single segment is shared as is, otherwise the segments are copied once
+		//into storage reserved for the whole chain (sizes are std::size_t all the way, chains may exceed 4 GiB)
+		DataBuffer flatten(std::pmr::memory_resource* t_resource=std::pmr::get_default_resource()) const
+		{
+			if(m_segments.size()==1 && *m_segments.front().getMemoryResource()==*t_resource)
+				return m_segments.front();
+			DataBuffer flat(0u,t_resource);
+			flat.reserve(m_size);
+			for(const DataBuffer& segment:m_segments)
+				flat.append(segment);
+			return flat;
+		}
+
+		friend std::ostream& operator<<(std::ostream& t_out,const BufferChain& t_chain)
+		{
+			for(const DataBuffer& segment:t_chain.m_segments)
+				t_out<<segment;
+			return t_out;
+		}
+
+	private:
+		std::pmr::vector<DataBuffer> m_segments;
+		std::size_t m_size=0;
+};
+
+//concatenation operators: a + b + c builds one chain, every step is a constant-time append
+inline BufferChain operator+(DataBuffer&& t_lhs,DataBuffer&& t_rhs)
+{
+	BufferChain chain;
+	chain.append(std::move(t_lhs));
+	chain.append(std::move(t_rhs));
+	return chain;
+}
+
+inline BufferChain operator+(const DataBuffer& t_lhs,DataBuffer&& t_rhs)
+{
+	BufferChain chain;
+	chain.append(t_lhs);
+	chain.append(std::move(t_rhs));
+	return chain;
+}
+
+inline BufferChain operator+(BufferChain&& t_chain,DataBuffer&& t_rhs)
+{
+	t_chain.append(std::move(t_rhs));
+	return std::move(t_chain);
+}
+
+inline BufferChain operator+(BufferChain&& t_chain,const DataBuffer& t_rhs)
+{
+	t_chain.append(t_rhs);
+	return std::move(t_chain);
+}
+
+#endif // BUFFERCHAIN_H
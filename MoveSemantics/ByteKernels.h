@@ -0,0 +1,344 @@
+#ifndef BYTEKERNELS_H
+#define BYTEKERNELS_H
+
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include<immintrin.h>
+#define BYTEKERNELS_X86 1
+#endif
+
+//Byte kernels used by DataBuffer: byte/pattern search, comparison, CRC32C and a 64-bit hash.
+//Each kernel has a portable scalar version and, on x86, SSE4.2 and AVX2 versions compiled with per-function
+//target attributes: the binary runs anywhere and the best version supported by the CPU is picked at runtime.
+//Every version returns exactly the same results and works on arbitrary binary data (NUL bytes included).
+namespace bytekernels{
+
+static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+enum class Isa{Scalar,Sse42,Avx2};
+
+inline Isa detectIsa()
+{
+#if defined(BYTEKERNELS_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2"))
+		return Isa::Avx2;
+	if(__builtin_cpu_supports("sse4.2"))
+		return Isa::Sse42;
+#endif
+	return Isa::Scalar;
+}
+
+inline Isa& selectedIsa()
+{
+	static Isa isa = detectIsa();
+	return isa;
+}
+
+inline Isa activeIsa(){return selectedIsa();}
+
+//forces a kernel set, e.g. to compare against the scalar one; never goes above what the CPU supports
+inline void setIsa(Isa t_isa)
+{
+	const Isa supported = detectIsa();
+	selectedIsa() = static_cast<int>(t_isa)<=static_cast<int>(supported) ? t_isa : supported;
+}
+
+namespace scalar{
+
+inline std::size_t find(const unsigned char* t_data,std::size_t t_size,unsigned char t_byte)
+{
+	for(std::size_t i=0;i<t_size;++i)
+		if(t_data[i]==t_byte)
+			return i;
+	return npos;
+}
+
+inline bool equals(const unsigned char* t_left,const unsigned char* t_right,std::size_t t_size)
+{
+	for(std::size_t i=0;i<t_size;++i)
+		if(t_left[i]!=t_right[i])
+			return false;
+	return true;
+}
+
+//t_length>=1
+inline std::size_t find(const unsigned char* t_data,std::size_t t_size,const unsigned char* t_pattern,std::size_t t_length)
+{
+	if(t_length>t_size)
+		return npos;
+	for(std::size_t i=0;i<=t_size-t_length;++i)
+		if(t_data[i]==t_pattern[0] && equals(t_data+i+1,t_pattern+1,t_length-1))
+			return i;
+	return npos;
+}
+
+//reflected Castagnoli polynomial, the one the SSE4.2 crc32 instruction implements
+inline constexpr std::array<std::uint32_t,256> makeCrc32cTable()
+{
+	std::array<std::uint32_t,256> table{};
+	for(std::uint32_t i=0;i<256;++i)
+	{
+		std::uint32_t crc = i;
+		for(int bit=0;bit<8;++bit)
+			crc = (crc>>1)^(0x82F63B78u&(0u-(crc&1u)));
+		table[i] = crc;
+	}
+	return table;
+}
+
+inline constexpr std::array<std::uint32_t,256> CRC32C_TABLE = makeCrc32cTable();
+
+inline std::uint32_t crc32c(std::uint32_t t_crc,const unsigned char* t_data,std::size_t t_size)
+{
+	for(std::size_t i=0;i<t_size;++i)
+		t_crc = CRC32C_TABLE[(t_crc^t_data[i])&0xffu]^(t_crc>>8);
+	return t_crc;
+}
+
+}
+
+#if defined(BYTEKERNELS_X86)
+namespace sse42{
+
+__attribute__((target("sse4.2"))) inline std::size_t find(const unsigned char* t_data,std::size_t t_size,unsigned char t_byte)
+{
+	const __m128i needle = _mm_set1_epi8(static_cast<char>(t_byte));
+	std::size_t i = 0;
+	for(;i+16<=t_size;i+=16)
+	{
+		const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t_data+i)),needle));
+		if(mask)
+			return i+static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+	}
+	const std::size_t rest = scalar::find(t_data+i,t_size-i,t_byte);
+	return rest==npos ? npos : i+rest;
+}
+
+__attribute__((target("sse4.2"))) inline bool equals(const unsigned char* t_left,const unsigned char* t_right,std::size_t t_size)
+{
+	std::size_t i = 0;
+	for(;i+16<=t_size;i+=16)
+	{
+		const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_left+i));
+		const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_right+i));
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(left,right))!=0xffff)
+			return false;
+	}
+	return scalar::equals(t_left+i,t_right+i,t_size-i);
+}
+
+//candidates are positions where both the first and the last pattern byte match, 16 positions per step
+__attribute__((target("sse4.2"))) inline std::size_t find(const unsigned char* t_data,std::size_t t_size,const unsigned char* t_pattern,std::size_t t_length)
+{
+	if(t_length>t_size)
+		return npos;
+	const __m128i first = _mm_set1_epi8(static_cast<char>(t_pattern[0]));
+	const __m128i last = _mm_set1_epi8(static_cast<char>(t_pattern[t_length-1]));
+	std::size_t i = 0;
+	for(;i+t_length-1+16<=t_size;i+=16)
+	{
+		const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_data+i));
+		const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_data+i+t_length-1));
+		unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first,first),_mm_cmpeq_epi8(block_last,last))));
+		for(;mask!=0;mask&=mask-1)
+		{
+			const std::size_t candidate = i+static_cast<std::size_t>(__builtin_ctz(mask));
+			if(std::memcmp(t_data+candidate+1,t_pattern+1,t_length-1)==0)
+				return candidate;
+		}
+	}
+	const std::size_t rest = scalar::find(t_data+i,t_size-i,t_pattern,t_length);
+	return rest==npos ? npos : i+rest;
+}
+
+__attribute__((target("sse4.2"))) inline std::uint32_t crc32c(std::uint32_t t_crc,const unsigned char* t_data,std::size_t t_size)
+{
+	std::size_t i = 0;
+#if defined(__x86_64__)
+	std::uint64_t crc = t_crc;
+	for(;i+8<=t_size;i+=8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word,t_data+i,8);
+		crc = _mm_crc32_u64(crc,word);
+	}
+	t_crc = static_cast<std::uint32_t>(crc);
+#endif
+	for(;i<t_size;++i)
+		t_crc = _mm_crc32_u8(t_crc,t_data[i]);
+	return t_crc;
+}
+
+}
+
+namespace avx2{
+
+__attribute__((target("avx2"))) inline std::size_t find(const unsigned char* t_data,std::size_t t_size,unsigned char t_byte)
+{
+	const __m256i needle = _mm256_set1_epi8(static_cast<char>(t_byte));
+	std::size_t i = 0;
+	for(;i+32<=t_size;i+=32)
+	{
+		const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_data+i)),needle)));
+		if(mask)
+			return i+static_cast<std::size_t>(__builtin_ctz(mask));
+	}
+	const std::size_t rest = sse42::find(t_data+i,t_size-i,t_byte);
+	return rest==npos ? npos : i+rest;
+}
+
+__attribute__((target("avx2"))) inline bool equals(const unsigned char* t_left,const unsigned char* t_right,std::size_t t_size)
+{
+	std::size_t i = 0;
+	for(;i+32<=t_size;i+=32)
+	{
+		const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_left+i));
+		const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_right+i));
+		if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(left,right)))!=0xffffffffu)
+			return false;
+	}
+	return sse42::equals(t_left+i,t_right+i,t_size-i);
+}
+
+__attribute__((target("avx2"))) inline std::size_t find(const unsigned char* t_data,std::size_t t_size,const unsigned char* t_pattern,std::size_t t_length)
+{
+	if(t_length>t_size)
+		return npos;
+	const __m256i first = _mm256_set1_epi8(static_cast<char>(t_pattern[0]));
+	const __m256i last = _mm256_set1_epi8(static_cast<char>(t_pattern[t_length-1]));
+	std::size_t i = 0;
+	for(;i+t_length-1+32<=t_size;i+=32)
+	{
+		const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_data+i));
+		const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_data+i+t_length-1));
+		unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(
+				_mm256_cmpeq_epi8(block_first,first),_mm256_cmpeq_epi8(block_last,last))));
+		for(;mask!=0;mask&=mask-1)
+		{
+			const std::size_t candidate = i+static_cast<std::size_t>(__builtin_ctz(mask));
+			if(std::memcmp(t_data+candidate+1,t_pattern+1,t_length-1)==0)
+				return candidate;
+		}
+	}
+	const std::size_t rest = sse42::find(t_data+i,t_size-i,t_pattern,t_length);
+	return rest==npos ? npos : i+rest;
+}
+
+}
+#endif
+
+//index of the first t_byte, npos if there is none
+inline std::size_t find(const unsigned char* t_data,std::size_t t_size,unsigned char t_byte)
+{
+#if defined(BYTEKERNELS_X86)
+	switch(activeIsa())
+	{
+		case Isa::Avx2: return avx2::find(t_data,t_size,t_byte);
+		case Isa::Sse42: return sse42::find(t_data,t_size,t_byte);
+		case Isa::Scalar: break;
+	}
+#endif
+	return scalar::find(t_data,t_size,t_byte);
+}
+
+//index of the first occurrence of the pattern, npos if there is none (an empty pattern is found at 0)
+inline std::size_t find(const unsigned char* t_data,std::size_t t_size,const unsigned char* t_pattern,std::size_t t_length)
+{
+	if(t_length==0)
+		return 0;
+	if(t_length==1)
+		return find(t_data,t_size,t_pattern[0]);
+#if defined(BYTEKERNELS_X86)
+	switch(activeIsa())
+	{
+		case Isa::Avx2: return avx2::find(t_data,t_size,t_pattern,t_length);
+		case Isa::Sse42: return sse42::find(t_data,t_size,t_pattern,t_length);
+		case Isa::Scalar: break;
+	}
+#endif
+	return scalar::find(t_data,t_size,t_pattern,t_length);
+}
+
+inline bool equals(const unsigned char* t_left,const unsigned char* t_right,std::size_t t_size)
+{
+#if defined(BYTEKERNELS_X86)
+	switch(activeIsa())
+	{
+		case Isa::Avx2: return avx2::equals(t_left,t_right,t_size);
+		case Isa::Sse42: return sse42::equals(t_left,t_right,t_size);
+		case Isa::Scalar: break;
+	}
+#endif
+	return scalar::equals(t_left,t_right,t_size);
+}
+
+//CRC-32C (Castagnoli, as in iSCSI/ext4/SCTP): crc32c("123456789")==0xE3069283
+inline std::uint32_t crc32c(const unsigned char* t_data,std::size_t t_size,std::uint32_t t_previous=0)
+{
+	const std::uint32_t crc = ~t_previous;
+#if defined(BYTEKERNELS_X86)
+	if(activeIsa()!=Isa::Scalar)
+		return ~sse42::crc32c(crc,t_data,t_size);
+#endif
+	return ~scalar::crc32c(crc,t_data,t_size);
+}
+
+//XXH64 (xxHash, 64-bit): fast non-cryptographic hash. Four independent multiply lanes already keep a scalar
+//core busy, so there is no SIMD version (AVX2 has no 64-bit multiply).
+inline std::uint64_t hash64(const unsigned char* t_data,std::size_t t_size,std::uint64_t t_seed=0)
+{
+	const std::uint64_t P1=11400714785074694791ull,P2=14029467366897019727ull,P3=1609587929392839161ull,
+			P4=9650029242287828579ull,P5=2870177450012600261ull;
+	auto rotl = [](std::uint64_t t_x,int t_r){return (t_x<<t_r)|(t_x>>(64-t_r));};
+	auto read64 = [](const unsigned char* t_p){std::uint64_t v; std::memcpy(&v,t_p,8); return v;};
+	auto read32 = [](const unsigned char* t_p){std::uint32_t v; std::memcpy(&v,t_p,4); return v;};
+	auto round = [&](std::uint64_t t_acc,std::uint64_t t_input){return rotl(t_acc+t_input*P2,31)*P1;};
+	auto merge = [&](std::uint64_t t_acc,std::uint64_t t_value){return (t_acc^round(0,t_value))*P1+P4;};
+
+	const unsigned char* p = t_data;
+	const unsigned char* const end = t_data+t_size;
+	std::uint64_t h;
+	if(t_size>=32)
+	{
+		std::uint64_t v1=t_seed+P1+P2,v2=t_seed+P2,v3=t_seed,v4=t_seed-P1;
+		for(;p+32<=end;p+=32)
+		{
+			v1 = round(v1,read64(p));
+			v2 = round(v2,read64(p+8));
+			v3 = round(v3,read64(p+16));
+			v4 = round(v4,read64(p+24));
+		}
+		h = rotl(v1,1)+rotl(v2,7)+rotl(v3,12)+rotl(v4,18);
+		h = merge(h,v1);
+		h = merge(h,v2);
+		h = merge(h,v3);
+		h = merge(h,v4);
+	}
+	else
+		h = t_seed+P5;
+	h += static_cast<std::uint64_t>(t_size);
+	for(;p+8<=end;p+=8)
+		h = rotl(h^round(0,read64(p)),27)*P1+P4;
+	if(p+4<=end)
+	{
+		h = rotl(h^(static_cast<std::uint64_t>(read32(p))*P1),23)*P2+P3;
+		p += 4;
+	}
+	for(;p<end;++p)
+		h = rotl(h^(*p*P5),11)*P1;
+	h ^= h>>33;
+	h *= P2;
+	h ^= h>>29;
+	h *= P3;
+	h ^= h>>32;
+	return h;
+}
+
+}
+
+#endif // BYTEKERNELS_H
@@ -0,0 +1,476 @@
+#ifndef DATABUFFER_H
+#define DATABUFFER_H
+
+#include<iostream>
+#include<cstring>
+#include<memory>
+#include<memory_resource>
+#include<algorithm>
+#include<atomic>
+#include<cstdint>
+#include<stdexcept>
+#include<string>
+#include<system_error>
+#include<cerrno>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#include "../Common/latency_histogram.h"
+#include "../Common/lifecycle_trace.h"
+#include "ByteKernels.h"
+
+#define DEFAULT_BUFFER_SIZE 100
+typedef unsigned char Byte;
+inline const Byte result[1]{'\0'};
+
+//Implementing sample class (DataBuffer) using Rule of 5: Copy/Move Constructor + Copy/Move Assignment Operator + Destructor
+//The bytes are allocated from a std::pmr::memory_resource (last constructor argument, default: new/delete)
+//
+//Storage:
+//	- small payloads (up to INLINE_CAPACITY bytes) live inside the object itself: no heap allocation (small buffer optimization)
+//	- larger payloads live in a reference counted SharedBlock: copies and slices share it and
+//	  the bytes are copied only when one of the sharing buffers is written to (copy-on-write)
+//	- a buffer only shares blocks allocated from its own memory resource, so a block never outlives its resource
+//	- DataBuffer::map(path) views a file through a read-only mmap: nothing is read or copied up front, pages are
+//	  loaded when touched, copies/slices share the mapping and the last one unmaps it; writing detaches (copy-on-write)
+//	- size and capacity are separate: append() grows the storage geometrically, clear() and setData() reuse it
+class DataBuffer{
+	public: 
+		static constexpr unsigned int INLINE_CAPACITY = 24;
+
+		static constexpr std::size_t npos = bytekernels::npos;
+
+		//madvise() hint for mapped buffers
+		enum class Access{Normal,Sequential,Random,WillNeed};
+
+		//t_data_size bytes of UNINITIALIZED content (size()==t_data_size, no spare capacity beyond the inline
+		//storage), to be filled through getMutableData(). For an empty buffer with room to append(): DataBuffer(0u)+reserve()
+		DataBuffer(unsigned int t_data_size=DEFAULT_BUFFER_SIZE,
+				std::pmr::memory_resource* t_resource=std::pmr::get_default_resource()):m_resource{t_resource}
+		{
+			LIFECYCLE_TRACE(this,"Default Constructor used. Based on BufferLength.");
+			allocate(t_data_size);
+		}
+
+		DataBuffer(const char* t_data,std::pmr::memory_resource* t_resource=std::pmr::get_default_resource()):m_resource{t_resource}
+		{
+			LIFECYCLE_TRACE(this,"Default Constructor used. Based on Initial Data.");
+			assign(t_data,strlen(t_data));
+		}
+
+		//binary data: exactly t_size bytes are copied, NUL bytes included
+		DataBuffer(const Byte* t_data,std::size_t t_size,std::pmr::memory_resource* t_resource=std::pmr::get_default_resource()):m_resource{t_resource}
+		{
+			LIFECYCLE_TRACE(this,"Default Constructor used. Based on Binary Data.");
+			assign(t_data,t_size);
+		}
+
+		~DataBuffer()
+		{
+			release();
+			LIFECYCLE_TRACE(this,"Default Destructor invoked");
+		}
+
+		//copy costructor (like std::pmr containers the copy uses the default resource, not the source one)
+		//no byte is copied unless the payload is small (inline) or lives in another memory resource
+		DataBuffer(const DataBuffer& other):m_resource{std::pmr::get_default_resource()}
+		{
+			LATENCY_SCOPE("DataBuffer copy constructor");
+			shareFrom(other);
+			LIFECYCLE_TRACE(this,"Copy Constructor used");
+		}
+
+		//Move Constructor using RValue Reference ( optional: use noexcept for better code optimization) Move Conxtructor will not throw
+		//the new object adopts the other's memory resource together with its data
+		DataBuffer(DataBuffer&& other) noexcept:m_resource{other.m_resource}
+		{
+			LATENCY_SCOPE("DataBuffer move constructor");
+			//grab/steal resource and data from  the other object
+			stealFrom(other);
+			LIFECYCLE_TRACE(this,"Move Constructor used");
+		}
+
+		//Copy Assignment Operator
+		DataBuffer& operator=(const DataBuffer&  other)
+		{
+			LATENCY_SCOPE("DataBuffer copy assignment");
+			//avoid self copy
+			if(this!=&other)
+			{
+				release();
+				shareFrom(other);
+			}
+			LIFECYCLE_TRACE(this,"Copy Assignment Operator used");
+			return *this;
+		}
+
+		//Move Assignment Operator
+		DataBuffer& operator=(DataBuffer&&  other)
+		{
+			LATENCY_SCOPE("DataBuffer move assignment");
+			//avoid self copy
+			if(this!=&other)
+			{
+				release();
+				if(other.m_block==nullptr || other.m_block->resource==nullptr || *m_resource==*other.m_resource)
+					stealFrom(other);
+				else
+				{
+					//the block must be returned to the resource it came from: different resources force a copy
+					assign(other.m_block->data()+other.m_offset,other.m_data_size);
+					other.release();
+				}
+			}
+			LIFECYCLE_TRACE(this,"Move Assignment Operator used");
+			return *this;
+		}
+
+		//read-only view of a whole file: throws std::system_error if it cannot be opened or mapped
+		//t_resource is used only if the buffer is later written to (the bytes are then copied out of the mapping)
+		static DataBuffer map(const std::string& t_path,Access t_access=Access::Sequential,
+				std::pmr::memory_resource* t_resource=std::pmr::get_default_resource())
+		{
+			const int fd = ::open(t_path.c_str(),O_RDONLY|O_CLOEXEC);
+			if(fd<0)
+				throw std::system_error(errno,std::generic_category(),"DataBuffer::map: cannot open "+t_path);
+			struct stat info;
+			if(::fstat(fd,&info)<0)
+			{
+				const int error = errno;
+				::close(fd);
+				throw std::system_error(error,std::generic_category(),"DataBuffer::map: cannot stat "+t_path);
+			}
+			DataBuffer buffer(0u,t_resource);
+			const std::size_t length = static_cast<std::size_t>(info.st_size);
+			if(length>0)
+			{
+				void* address = ::mmap(nullptr,length,PROT_READ,MAP_PRIVATE,fd,0);
+				const int error = errno;
+				::close(fd);	//the mapping keeps its own reference to the file
+				if(address==MAP_FAILED)
+					throw std::system_error(error,std::generic_category(),"DataBuffer::map: cannot map "+t_path);
+				try
+				{
+					buffer.m_block = new SharedBlock{{1},length,nullptr,static_cast<Byte*>(address)};
+				}
+				catch(...)
+				{
+					::munmap(address,length);	//nobody owns the mapping yet
+					throw;
+				}
+				buffer.m_data_size = length;
+				buffer.advise(t_access);
+			}
+			else
+				::close(fd);
+			return buffer;
+		}
+
+		//access hint for the viewed bytes of a mapped buffer (no effect on other buffers)
+		void advise(Access t_access) const
+		{
+			if(!isMapped() || m_data_size==0)
+				return;
+			static const int advice[]={MADV_NORMAL,MADV_SEQUENTIAL,MADV_RANDOM,MADV_WILLNEED};
+			//madvise needs a page aligned start: widen the range down to the page of the first byte
+			const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+			const std::size_t start = m_offset/page*page;
+			::madvise(m_block->mapping+start,m_offset+m_data_size-start,advice[static_cast<int>(t_access)]);
+		}
+
+		//concatenation (a + b + ...) builds a BufferChain, see BufferChain.h
+
+		//replaces the content, reusing the current storage when it is not shared and the data fits
+		void setData(const char* t_data)
+		{
+			setData(reinterpret_cast<const Byte*>(t_data),strlen(t_data));
+		}
+
+		void setData(const Byte* t_data,std::size_t t_size)
+		{
+			LATENCY_SCOPE("DataBuffer::setData");
+			clear();
+			append(t_data,t_size);
+			LIFECYCLE_TRACE(this,"SetData invoked");
+		}
+
+		//Size and capacity: appending grows the storage geometrically (x2) and clear() keeps it, so a buffer
+		//reused in a loop stops allocating once it has reached the largest size it needs.
+		//capacity: bytes the buffer can hold without allocating. A shared or mapped buffer has no room of
+		//its own (writing copies it anyway): its capacity is its size.
+		std::size_t capacity() const
+		{
+			if(m_block==nullptr)
+				return INLINE_CAPACITY;
+			return ownsStorage() ? m_block->capacity-m_offset : m_data_size;
+		}
+
+		//makes room for at least t_capacity bytes (a shared or mapped buffer gets its own copy)
+		void reserve(std::size_t t_capacity)
+		{
+			if(t_capacity>capacity() || !ownsStorage())
+				reallocate(std::max(t_capacity,m_data_size));
+		}
+
+		//appends t_size bytes, which may point into this buffer
+		void append(const Byte* t_data,std::size_t t_size)
+		{
+			const std::size_t new_size = m_data_size+t_size;
+			if(new_size>capacity() || !ownsStorage())
+			{
+				reallocate(std::max(new_size,2*capacity()),t_data,t_size);
+				return;
+			}
+			if(t_size>0)
+				std::memmove(const_cast<Byte*>(bytes())+m_data_size,t_data,t_size);
+			m_data_size = new_size;
+		}
+
+		void append(const char* t_data)
+		{
+			append(reinterpret_cast<const Byte*>(t_data),strlen(t_data));
+		}
+
+		void append(const DataBuffer& t_other)
+		{
+			append(t_other.bytes(),t_other.m_data_size);
+		}
+
+		//empties the buffer: its own storage is kept for the next data, shared storage is released
+		void clear()
+		{
+			if(ownsStorage())
+			{
+				m_offset = 0;
+				m_data_size = 0;
+			}
+			else
+				release();
+		}
+
+		//gives the unused capacity back (down to the inline storage for small payloads)
+		void shrink_to_fit()
+		{
+			if(m_block!=nullptr && ownsStorage() && m_block->capacity-m_offset>m_data_size)
+				reallocate(m_data_size);
+		}
+
+		//zero-copy view of [t_offset, t_offset+t_length): shares the parent's block (small payloads are copied inline)
+		DataBuffer slice(std::size_t t_offset,std::size_t t_length) const
+		{
+			if(t_offset>m_data_size || t_length>m_data_size-t_offset)
+				throw std::out_of_range("DataBuffer::slice: range exceeds buffer size");
+			DataBuffer view(0u,m_resource);
+			if(m_block==nullptr)
+			{
+				//an inline buffer holds at most INLINE_CAPACITY bytes, so does the slice
+				const std::size_t offset = std::min<std::size_t>(t_offset,INLINE_CAPACITY);
+				view.assign(m_inline+offset,std::min<std::size_t>(t_length,INLINE_CAPACITY-offset));
+			}
+			else if(t_length>INLINE_CAPACITY)
+			{
+				m_block->refs.fetch_add(1,std::memory_order_relaxed);
+				view.m_block=m_block;
+				view.m_offset=m_offset+t_offset;
+				view.m_data_size=t_length;
+			}
+			else
+				view.assign(m_block->data()+m_offset+t_offset,t_length);
+			return view;
+		}
+		
+		const Byte* getData() const
+		{
+			if(m_data_size > 0) 
+				return bytes();
+			else
+			{
+				return result;
+			}
+		} 
+
+		//write access: detaches from the shared block first if anyone else is using it (copy-on-write),
+		//and always from a file mapping, which is read-only
+		Byte* getMutableData()
+		{
+			if(m_block!=nullptr && (m_block->refs.load(std::memory_order_acquire)>1 || isMapped()))
+			{
+				SharedBlock* shared = m_block;
+				const std::size_t offset = m_offset;
+				m_block = nullptr;
+				assign(shared->data()+offset,m_data_size);
+				unref(shared);
+			}
+			return const_cast<Byte*>(bytes());
+		}
+
+		//search, comparison and checksums run the SIMD kernels of ByteKernels.h (chosen for the CPU at runtime)
+		//find: index of the first match at or after t_from, npos if there is none
+		std::size_t find(Byte t_byte,std::size_t t_from=0) const
+		{
+			if(t_from>=m_data_size)
+				return npos;
+			const std::size_t index = bytekernels::find(bytes()+t_from,m_data_size-t_from,t_byte);
+			return index==npos ? npos : t_from+index;
+		}
+
+		std::size_t find(const Byte* t_pattern,std::size_t t_length,std::size_t t_from=0) const
+		{
+			if(t_from>m_data_size)
+				return npos;
+			const std::size_t index = bytekernels::find(bytes()+t_from,m_data_size-t_from,t_pattern,t_length);
+			return index==npos ? npos : t_from+index;
+		}
+
+		std::size_t find(const DataBuffer& t_pattern,std::size_t t_from=0) const
+		{
+			return find(t_pattern.bytes(),t_pattern.m_data_size,t_from);
+		}
+
+		//same bytes (buffers sharing the same storage compare without reading it)
+		bool equals(const DataBuffer& t_other) const
+		{
+			if(m_data_size!=t_other.m_data_size)
+				return false;
+			return bytes()==t_other.bytes() || bytekernels::equals(bytes(),t_other.bytes(),m_data_size);
+		}
+
+		std::uint32_t crc32c() const {return bytekernels::crc32c(bytes(),m_data_size);}
+		std::uint64_t hash() const {return bytekernels::hash64(bytes(),m_data_size);}
+
+		std::size_t size() const {return m_data_size;}
+		bool isInline() const {return m_block==nullptr;}
+		bool isMapped() const {return m_block!=nullptr && m_block->mapping!=nullptr;}
+		//number of buffers sharing the same storage (1 for inline or unshared buffers)
+		unsigned int useCount() const {return m_block ? m_block->refs.load(std::memory_order_relaxed) : 1;}
+		std::pmr::memory_resource* getMemoryResource() const {return m_resource;}
+
+		//prints exactly size() bytes: buffers are neither NUL terminated nor limited to text
+		friend std::ostream& operator<<(std::ostream& t_out,const DataBuffer& t_buffer)
+		{
+			return t_out.write(reinterpret_cast<const char*>(t_buffer.bytes()),t_buffer.m_data_size);
+		}
+
+	private:
+		//either a header followed by the bytes, allocated from a memory resource,
+		//or (resource==nullptr) a heap allocated header of a file mapping, shareable by any buffer
+		struct SharedBlock{
+			std::atomic<unsigned int> refs;
+			std::size_t capacity;
+			std::pmr::memory_resource* resource;
+			Byte* mapping;
+
+			Byte* data(){return mapping ? mapping : reinterpret_cast<Byte*>(this+1);}
+		};
+
+		const Byte* bytes() const {return m_block ? m_block->data()+m_offset : m_inline;}
+
+		//prepares room for t_size bytes: inline when it fits, otherwise a new unshared block
+		void allocate(std::size_t t_size)
+		{
+			m_data_size = t_size;
+			m_offset = 0;
+			if(t_size<=INLINE_CAPACITY)
+				return;
+			void* memory = m_resource->allocate(sizeof(SharedBlock)+t_size,alignof(SharedBlock));
+			m_block = ::new (memory) SharedBlock{{1},t_size,m_resource,nullptr};
+		}
+
+		//true if the buffer may write to its storage: inline, or a block used by nobody else
+		bool ownsStorage() const
+		{
+			return m_block==nullptr || (m_block->mapping==nullptr && m_block->refs.load(std::memory_order_acquire)==1);
+		}
+
+		//moves the bytes to unshared storage of t_capacity bytes (inline when it fits), then appends t_extra:
+		//the old storage is released last, so t_extra may point into it
+		void reallocate(std::size_t t_capacity,const Byte* t_extra=nullptr,std::size_t t_extra_size=0)
+		{
+			SharedBlock* old_block = m_block;
+			const Byte* old_bytes = bytes();
+			SharedBlock* block = nullptr;
+			if(t_capacity>INLINE_CAPACITY)
+			{
+				void* memory = m_resource->allocate(sizeof(SharedBlock)+t_capacity,alignof(SharedBlock));
+				block = ::new (memory) SharedBlock{{1},t_capacity,m_resource,nullptr};
+			}
+			Byte* target = block ? block->data() : m_inline;
+			if(target!=old_bytes)
+				std::copy(old_bytes,old_bytes+m_data_size,target);
+			if(t_extra_size>0)
+				std::memmove(target+m_data_size,t_extra,t_extra_size);
+			m_block = block;
+			m_offset = 0;
+			m_data_size += t_extra_size;
+			if(old_block!=nullptr)
+				unref(old_block);
+		}
+
+		template<typename T>
+		void assign(const T* t_data,std::size_t t_size)
+		{
+			allocate(t_size);
+			std::copy(t_data,t_data + t_size,const_cast<Byte*>(bytes()));
+		}
+
+		void shareFrom(const DataBuffer& other)
+		{
+			if(other.m_block!=nullptr && (other.m_block->resource==nullptr || *other.m_block->resource==*m_resource))
+			{
+				other.m_block->refs.fetch_add(1,std::memory_order_relaxed);
+				m_block = other.m_block;
+				m_offset = other.m_offset;
+				m_data_size = other.m_data_size;
+			}
+			else
+				assign(other.bytes(),other.m_data_size);
+		}
+
+		void stealFrom(DataBuffer& other) noexcept
+		{
+			m_block = other.m_block;
+			m_offset = other.m_offset;
+			m_data_size = other.m_data_size;
+			if(m_block==nullptr)
+				std::copy(other.m_inline,other.m_inline + m_data_size,m_inline);
+			//reset other's block pointer to avoid data free by the other's distructor (RValueReferece will go out of scope at the end)
+			other.m_block = nullptr;
+			other.m_offset = 0;
+			other.m_data_size = 0;
+		}
+
+		static void unref(SharedBlock* t_block)
+		{
+			if(t_block->refs.fetch_sub(1,std::memory_order_acq_rel)==1)
+			{
+				if(t_block->mapping!=nullptr)
+				{
+					::munmap(t_block->mapping,t_block->capacity);
+					delete t_block;
+					return;
+				}
+				std::pmr::memory_resource* resource = t_block->resource;
+				const std::size_t capacity = t_block->capacity;
+				t_block->~SharedBlock();
+				resource->deallocate(t_block,sizeof(SharedBlock)+capacity,alignof(SharedBlock));
+			}
+		}
+
+		void release()
+		{
+			if(m_block!=nullptr)
+				unref(m_block);
+			m_block = nullptr;
+			m_offset = 0;
+			m_data_size = 0;
+		}
+
+		std::pmr::memory_resource* m_resource;
+		SharedBlock* m_block=nullptr;
+		std::size_t m_offset=0;
+		std::size_t m_data_size=0;
+		Byte m_inline[INLINE_CAPACITY];
+};
+
+#endif // DATABUFFER_H
@@ -0,0 +1,36 @@
+#include<iostream>
+#include "MyClass.h"
+#include "MyClassArray.h"
+
+/*
+	Sample code to demonstrate expression templates (MyClassExpr.h, MyClassArray.h):
+	a+b+c does not build a temporary per addition, it builds a small object describing the sum,
+	evaluated in one pass when it is turned into a MyClass (or a MyClassArray).
+	Build: g++ -std=c++17 ExprTemplateSample.cpp
+*/
+
+using namespace std;
+
+int main()
+{
+	MyClass a(5);
+	MyClass a2 = a;
+	//chained additions are fused: one evaluation for the whole chain, no temporary per +
+	MyClass sum = a+a2+MyClass(1)+MyClass(2);
+	cout<<"a+a2+1+2 value: "<<sum.data()<<endl;
+	//assigning a chain to an existing object evaluates it before the store, so a=a+a2 is fine
+	a = a+a2;
+	cout<<"a=a+a2 value: "<<a.data()<<endl;
+
+	//batch version: one vectorized loop over contiguous storage for the whole chain
+	MyClassArray xs{1,2,3,4},ys{10,20,30,40},zs{100,200,300,400};
+	MyClassArray totals = xs+ys+zs;
+	cout<<"xs+ys+zs:";
+	for(std::size_t i=0;i<totals.size();++i)
+		cout<<" "<<totals[i];
+	cout<<endl;
+	//in LIFECYCLE_TRACE_RING mode the constructor/assignment messages were buffered: print them now
+	lifecycle::dump();
+
+	return 0;
+}
@@ -1,6 +1,9 @@
 #include<iostream>
-#include<cstring>
 #include<memory>
+#include<memory_resource>
+#include "../Common/latency_histogram.h"
+#include "DataBuffer.h"
+#include "BufferChain.h"
 /*
 	In this sample code I tried to demonstrate use of move semantics using RValue References in modern C++
 	Special thanks to this link: https://www.internalpointers.com/post/c-rvalue-references-and-move-semantics-beginners
@@ -17,119 +20,10 @@
 		To summarize, RVO is a compiler optimization technique, while std::move is just an rvalue cast,
 		which also instructs the compiler that it's eligible to move the object. The price of moving is 
 		lower than copying but higher than RVO, so never apply std::move to local objects if they would otherwise be eligible for the RVO.
-		
-*/
 
-#define DEFAULT_BUFFER_SIZE 100
-typedef unsigned char Byte;
-const Byte result[1]{'\0'};
-
-//Implementing sample class (DataBuffer) using Rule of 5: Copy/Move Constructor + Copy/Move Assignment Operator + Destructor
-class DataBuffer{
-	public: 
-		DataBuffer(unsigned int t_data_size=DEFAULT_BUFFER_SIZE)
-		{
-			std::cout<<"Default Constructor used. Based on BufferLength."<<std::endl;
-			m_data_size=t_data_size;
-			m_data=new Byte[m_data_size];
-		}
-
-		DataBuffer(const char* t_data)
-		{
-			std::cout<<"Default Constructor used. Based on Initial Data."<<std::endl;
-                        m_data_size = strlen(t_data);
-                        m_data=new Byte[m_data_size];
-                        std::copy(t_data,t_data + m_data_size, m_data);	
-		}
-
-		~DataBuffer()
-		{
-			m_data_size = 0;
-			delete [] m_data;
-			std::cout<<"Default Destructor invoked"<<std::endl;
-		}
-
-		//copy costructor
-		DataBuffer(const DataBuffer& other)
-		{
-			m_data_size = other.m_data_size;
-			m_data = new Byte[m_data_size];
-			std::copy(other.m_data,other.m_data + m_data_size,m_data);
-			std::cout<<"Copy Constructor used"<<std::endl;
-		}
-
-		//Move Constructor using RValue Reference ( optional: use noexcept for better code optimization) Move Conxtructor will not throw
-		DataBuffer(DataBuffer&& other) noexcept
-		{
-			//grab/steal resource and data from  the other object
-			m_data_size = other.m_data_size;
-			m_data = other.m_data;
-			//reset other's data pointer to avoid data free by the other's distructor (RValueReferece will go out of scope at the end)
-			other.m_data=nullptr;
-			other.m_data_size = 0;
-			std::cout<<"Move Constructor used"<<std::endl;
-		}
-
-		//Copy Assignment Operator
-		DataBuffer& operator=(const DataBuffer&  other)
-		{
-			//avoid self copy
-			if(this!=&other)
-			{
-				delete[] m_data;
-				m_data=nullptr;
-	                        m_data_size = other.m_data_size;
-        	                m_data = new Byte[m_data_size];
-                	        std::copy(other.m_data,other.m_data + m_data_size,m_data);
-			}
-			std::cout<<"Copy Assignment Operator used"<<std::endl;
-			return *this;
-		}
-
-		//Move Assignment Operator
-		DataBuffer& operator=(DataBuffer&&  other)
-		{
-			//avoid self copy
-			if(this!=&other)
-			{
-				delete[] m_data;
-								m_data_size = other.m_data_size;
-								m_data = other.m_data;
-				other.m_data = nullptr;
-				other.m_data_size = 0;
-			}
-			std::cout<<"Move Assignment Operator used"<<std::endl;
-			return *this;
-		}
-
-		DataBuffer& operator+(DataBuffer&& other)
-		{
-			
-		}
-
-		void setData(const char* t_data)
-		{
-			delete[] m_data;
-			m_data_size = strlen(t_data);
-			m_data=new Byte[m_data_size];
-			std::copy(t_data,t_data + m_data_size, m_data);
-			std::cout<<"SetData invoked"<<std::endl;
-		}
+	DataBuffer itself lives in DataBuffer.h so the benchmarks can reuse it.
 		
-		const Byte* getData() 
-		{
-			if(m_data!=nullptr || m_data_size > 0) 
-				return m_data;
-			else
-			{
-				return result;
-			}
-		} 
-
-	private:
-		unsigned int  m_data_size;
-		Byte* m_data;
-};
+*/
 
 //This function is placed only for learing purpose
 DataBuffer createInputBuffer()
@@ -145,7 +39,7 @@ DataBuffer createInputBuffer()
 
 void printBuffer(DataBuffer&& buffer)
 {
-	std::cout<<"Inside printBuffer: "<<buffer.getData()<<std::endl;
+	std::cout<<"Inside printBuffer: "<<buffer<<std::endl;
 }
 
 int main()
@@ -153,30 +47,87 @@ int main()
 	//Test DataBuffer using sample data
 	DataBuffer db1(10);
 	db1.setData("Hello");
-	std::cout<<"Data1: "<<db1.getData()<<std::endl;
+	std::cout<<"Data1: "<<db1<<std::endl;
 
 	//Move Constructor will be invoked: remember to disable RVO : g++ -fno-elide-constructors MoveSemantic.cpp
 	DataBuffer db2 (createInputBuffer());	
-	std::cout<<"Data2: "<<db2.getData()<<std::endl;
+	std::cout<<"Data2: "<<db2<<std::endl;
 	
 	db2 = db1;
 	
 	db2 = DataBuffer("TempBuffer");
-	std::cout<<"Data2: "<<db2.getData()<<std::endl;
+	std::cout<<"Data2: "<<db2<<std::endl;
 
 	db2 = std::move(db1);
-	std::cout<<"Data2: "<<db2.getData()<<std::endl;
+	std::cout<<"Data2: "<<db2<<std::endl;
 
-	std::cout<<"Data1 moved: "<<db1.getData()<<std::endl;
+	std::cout<<"Data1 moved: "<<db1<<std::endl;
 
 	printBuffer(DataBuffer("On the Fly Buffer"));
 
 	db1.setData(" Modern C++!");
-	std::cout<<"Set db1 again to '"<<db1.getData()<<"'"<<std::endl;
+	std::cout<<"Set db1 again to '"<<db1<<"'"<<std::endl;
 	std::cout<<"Swapping db1 and db2 data using Move Semantics"<<std::endl;
         std::swap(db1,db2);
 
-        std::cout<<"Final Message: "<<db1.getData()<<db2.getData()<<std::endl;
+        std::cout<<"Final Message: "<<db1<<db2<<std::endl;
+
+	//Polymorphic memory resources: all buffers of this batch come from one stack arena, no heap allocation at all
+	Byte arena_storage[256];
+	std::pmr::monotonic_buffer_resource arena(arena_storage,sizeof(arena_storage),std::pmr::null_memory_resource());
+	DataBuffer db3("Arena",&arena);
+	DataBuffer db4(" Buffers",&arena);
+	//db1 uses the default resource: moving between different resources copies instead of stealing the pointer
+	db1 = std::move(db3);
+	std::swap(db2,db4);
+	std::cout<<"Arena Message: "<<db1<<db2<<std::endl;
+
+	//Copy-on-write: copies and slices of a large buffer share its storage until one of them is written to
+	DataBuffer frame("HEADER|a payload too long to be stored inline|TRAILER");
+	DataBuffer frame_copy = frame;
+	DataBuffer payload = frame.slice(7,38);
+	std::cout<<"Slice: '"<<payload<<"' sharing storage with "<<payload.useCount()-1<<" other buffer(s)"<<std::endl;
+	frame_copy.getMutableData()[0]='h';
+	std::cout<<"After writing to the copy: '"<<frame_copy<<"' vs original '"<<frame<<"'"<<std::endl;
+
+	//Concatenation with operator+ moves the buffers into a segment chain instead of reallocating and copying
+	BufferChain message = DataBuffer("Moved ") + DataBuffer("buffers ") + DataBuffer("are chained: ");
+	message = std::move(message) + payload;
+	std::cout<<"Chain of "<<message.segmentCount()<<" segments ("<<message.size()<<" bytes): "<<message<<std::endl;
+	DataBuffer flat = message.flatten();
+	std::cout<<"Flattened into one buffer: "<<flat<<std::endl;
+
+	//Binary payloads keep their NUL bytes; search, compare and checksum use the SIMD kernels picked for this CPU
+	const Byte packet[]={'S','Y','N',0,0,7,'|','d','a','t','a','|','E','N','D'};
+	DataBuffer binary(packet,sizeof(packet));
+	DataBuffer received(packet,sizeof(packet));
+	const Byte trailer[]={'|','E','N','D'};
+	std::cout<<"Binary buffer of "<<binary.size()<<" bytes: first '|' at "<<binary.find('|')<<", trailer at "<<binary.find(trailer,sizeof(trailer))
+			<<", crc32c "<<std::hex<<binary.crc32c()<<std::dec<<", equal to the received one: "<<std::boolalpha<<binary.equals(received)<<std::endl;
+
+	//A file mapped instead of read: only the touched pages are loaded, copies and moves share the mapping
+	DataBuffer image = DataBuffer::map("/proc/self/exe",DataBuffer::Access::Random);
+	DataBuffer image_header = image.slice(1,3);
+	std::cout<<"Mapped own executable: "<<image.size()<<" bytes, header '"<<image_header<<"'"<<std::endl;
+
+	//A receive buffer reused for every message: clear() keeps the storage and append() grows it geometrically
+	DataBuffer receive_buffer(0u);
+	receive_buffer.reserve(64);
+	for(const char* chunk:{"first message, longer than the inline storage","second","third one"})
+	{
+		receive_buffer.clear();
+		receive_buffer.append(chunk);
+		receive_buffer.append(" [received]");
+		std::cout<<"Received '"<<receive_buffer<<"' ("<<receive_buffer.size()<<"/"<<receive_buffer.capacity()<<" bytes)"<<std::endl;
+	}
+	receive_buffer.shrink_to_fit();
+	std::cout<<"After shrink_to_fit: "<<receive_buffer.capacity()<<" bytes of capacity, inline: "<<receive_buffer.isInline()<<std::endl;
+
+	//built with LATENCY_HISTOGRAMS=1: latency percentiles of the instrumented operations (prints nothing otherwise)
+	latency::writeText(std::cout);
+
+	//in LIFECYCLE_TRACE_RING mode the constructor/assignment messages were buffered: print them now
+	lifecycle::dump();
 
 	return 0;
 }
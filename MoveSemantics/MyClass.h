@@ -0,0 +1,69 @@
+#ifndef MYCLASS_H
+#define MYCLASS_H
+
+#include<iostream>
+#include "../Common/lifecycle_trace.h"
+#include "MyClassExpr.h"
+
+//Sample class of RValueSample.cpp: copy constructor and copy assignment only, so std::move falls back to a copy
+//operator+ builds an expression (MyClassExpr.h), evaluated when it is turned into a MyClass
+class MyClass : public MyClassExpression<MyClass>{
+	public:
+		//default constructor initilaizes m_data property
+		MyClass(){m_data=0;}
+		
+		//copy constructor
+		MyClass(const MyClass& _A)
+		{
+			LIFECYCLE_TRACE(this,"Copy Constructor invoked.");
+			m_data=_A.m_data;
+		}
+
+		//will avoid MyClass a=2  and will raise an error. it prevents from unwanted casting data types 
+		explicit MyClass(int t_data):m_data{t_data}{
+			LIFECYCLE_TRACE(this,"Regular value based constructor invoked: MyClass(int t_data)");
+		}
+
+		//assignment operator to copy m_data from one object of type MyClass to another of the same time
+		MyClass& operator=(const MyClass& _A)
+		{
+			LIFECYCLE_TRACE(this,"Assignment Operator Invoked.");
+			if(this!=&_A)
+			{
+				m_data=_A.m_data;
+			}
+			return *this;
+		}
+
+		//evaluates a whole chain of additions (a+b+c+...) in one pass: one object, however long the chain
+		//not explicit, so a sum can be passed wherever a MyClass is expected
+		template<typename E>
+		MyClass(const MyClassExpression<E>& t_expression):m_data{t_expression.data()}
+		{
+			LIFECYCLE_TRACE(this,"Addition Expression evaluated");
+		}
+
+		template<typename E>
+		MyClass& operator=(const MyClassExpression<E>& t_expression)
+		{
+			LIFECYCLE_TRACE(this,"Addition Expression assigned");
+			m_data=t_expression.data();	//fully evaluated before the store, so a=a+b is fine
+			return *this;
+		}
+
+		//simple getter method
+		int data() const {return m_data;}
+	private:
+		int m_data;
+};
+
+template<typename L,typename R>
+template<typename E>
+MyClass MyClassSum<L,R>::operator=(const MyClassExpression<E>& t_value) const
+{
+	MyClass materialized(*this);
+	materialized = t_value;
+	return materialized;
+}
+
+#endif // MYCLASS_H
@@ -0,0 +1,107 @@
+#ifndef MYCLASSARRAY_H
+#define MYCLASSARRAY_H
+
+#include<cstddef>
+#include<initializer_list>
+#include<stdexcept>
+#include<vector>
+#include "../Common/lifecycle_trace.h"
+
+//Batch version of MyClass: N values in one contiguous int array instead of N objects.
+//x+y+z builds an expression like MyClassExpr.h does; assigning it runs one fused loop
+//out[i]=x[i]+y[i]+z[i] over the whole array (no temporary array per addition) that the compiler vectorizes.
+//An expression refers to its arrays: evaluate it in the same statement, do not keep it in an auto variable.
+
+class MyClassArray;
+
+template<typename Derived>
+class MyClassArrayExpression{
+	public:
+		const Derived& self() const {return static_cast<const Derived&>(*this);}
+		std::size_t size() const {return self().size();}
+		int operator[](std::size_t t_index) const {return self()[t_index];}
+};
+
+//arrays are referenced, nested sums are held by value
+template<typename E>
+struct MyClassArrayOperand{typedef E type;};
+template<>
+struct MyClassArrayOperand<MyClassArray>{typedef const MyClassArray& type;};
+
+template<typename L,typename R>
+class MyClassArraySum : public MyClassArrayExpression<MyClassArraySum<L,R>>{
+	public:
+		MyClassArraySum(const L& t_left,const R& t_right):m_left{t_left},m_right{t_right}
+		{
+			if(t_left.size()!=t_right.size())
+				throw std::invalid_argument("MyClassArray: adding arrays of different sizes");
+		}
+		std::size_t size() const {return m_left.size();}
+		int operator[](std::size_t t_index) const {return m_left[t_index]+m_right[t_index];}
+	private:
+		typename MyClassArrayOperand<L>::type m_left;
+		typename MyClassArrayOperand<R>::type m_right;
+};
+
+template<typename L,typename R>
+MyClassArraySum<L,R> operator+(const MyClassArrayExpression<L>& t_left,const MyClassArrayExpression<R>& t_right)
+{
+	return MyClassArraySum<L,R>(t_left.self(),t_right.self());
+}
+
+class MyClassArray : public MyClassArrayExpression<MyClassArray>{
+	public:
+		explicit MyClassArray(std::size_t t_size=0,int t_value=0):m_data(t_size,t_value){}
+		MyClassArray(std::initializer_list<int> t_values):m_data(t_values){}
+
+		template<typename E>
+		MyClassArray(const MyClassArrayExpression<E>& t_expression):m_data(t_expression.size())
+		{
+			LIFECYCLE_TRACE(this,"Array Expression evaluated");
+			evaluate(t_expression.self());
+		}
+
+		//element-wise: each element is read before it is written, so x=x+y is fine
+		template<typename E>
+		MyClassArray& operator=(const MyClassArrayExpression<E>& t_expression)
+		{
+			LIFECYCLE_TRACE(this,"Array Expression assigned");
+			if(t_expression.size()!=m_data.size())
+				m_data.resize(t_expression.size());
+			evaluate(t_expression.self());
+			return *this;
+		}
+
+		std::size_t size() const {return m_data.size();}
+		int operator[](std::size_t t_index) const {return m_data[t_index];}
+		int& operator[](std::size_t t_index){return m_data[t_index];}
+		const int* data() const {return m_data.data();}
+		int* data(){return m_data.data();}
+
+	private:
+		//fixed-width blocks give the vectorizer a known trip count (8 ints = one AVX2 register) even at -O2;
+		//the block is computed into a local first, so the loads never have to be checked against the stores to out
+		static const std::size_t BLOCK = 8;
+
+		template<typename E>
+		void evaluate(const E& t_expression)
+		{
+			int* out = m_data.data();
+			const std::size_t count = m_data.size();
+			std::size_t i = 0;
+			for(;i+BLOCK<=count;i+=BLOCK)
+			{
+				int block[BLOCK];
+				for(std::size_t j=0;j<BLOCK;++j)
+					block[j] = t_expression[i+j];
+				for(std::size_t j=0;j<BLOCK;++j)
+					out[i+j] = block[j];
+			}
+			for(;i<count;++i)
+				out[i] = t_expression[i];
+		}
+
+		std::vector<int> m_data;
+};
+
+#endif // MYCLASSARRAY_H
@@ -0,0 +1,46 @@
+#ifndef MYCLASSEXPR_H
+#define MYCLASSEXPR_H
+
+//Expression templates for MyClass arithmetic.
+//a+b+c+d does not compute anything: it builds a small MyClassSum<MyClassSum<...>> object describing the sum.
+//The whole chain is evaluated in one pass when it is converted or assigned to a MyClass, so no temporary
+//MyClass (and no constructor/destructor call) is created per addition.
+//An expression refers to its MyClass operands: evaluate it in the same statement, do not keep it in an auto variable.
+
+class MyClass;
+
+//CRTP base of everything that can appear in a MyClass sum
+template<typename Derived>
+class MyClassExpression{
+	public:
+		int data() const {return static_cast<const Derived&>(*this).data();}
+};
+
+//MyClass operands are referenced, nested sums (temporaries of the same statement) are held by value
+template<typename E>
+struct MyClassOperand{typedef E type;};
+template<>
+struct MyClassOperand<MyClass>{typedef const MyClass& type;};
+
+template<typename L,typename R>
+class MyClassSum : public MyClassExpression<MyClassSum<L,R>>{
+	public:
+		MyClassSum(const L& t_left,const R& t_right):m_left{t_left},m_right{t_right}{}
+		int data() const {return m_left.data()+m_right.data();}
+
+		//a+b=c still compiles like it did with an eager operator+: the sum is materialized into a MyClass
+		//rvalue which gets the new value, a and b are not changed (defined in MyClass.h, MyClass is incomplete here)
+		template<typename E>
+		MyClass operator=(const MyClassExpression<E>& t_value) const;
+	private:
+		typename MyClassOperand<L>::type m_left;
+		typename MyClassOperand<R>::type m_right;
+};
+
+template<typename L,typename R>
+MyClassSum<L,R> operator+(const MyClassExpression<L>& t_left,const MyClassExpression<R>& t_right)
+{
+	return MyClassSum<L,R>(static_cast<const L&>(t_left),static_cast<const R&>(t_right));
+}
+
+#endif // MYCLASSEXPR_H
@@ -1,4 +1,5 @@
 #include<iostream> 
+#include "MyClass.h"
 
 //Sample code to demonstrate RValue reference concept
 
@@ -23,50 +24,6 @@ R-values 			Yes 				No
 
 using namespace std;
 
-class MyClass{
-	public:
-		//default constructor initilaizes m_data property
-		MyClass(){m_data=0;}
-		
-		//copy constructor
-		MyClass(const MyClass& _A)
-		{
-			cout<<"Copy Constructor invoked."<<endl;
-			m_data=_A.m_data;
-		}
-
-		//will avoid MyClass a=2  and will raise an error. it prevents from unwanted casting data types 
-		explicit MyClass(int t_data):m_data{t_data}{
-			cout<<"Regular value based constructor invoked: MyClass(int t_data)"<<endl;
-		}
-
-		//assignment operator to copy m_data from one object of type MyClass to another of the same time
-		MyClass& operator=(const MyClass& _A)
-		{
-			cout<<"Assignment Operator Invoked."<<endl;
-			if(this!=&_A)
-			{
-				m_data=_A.m_data;
-			}
-			return *this;
-		}
-
-		//plus (add) operator to return sum of 2 objects of type MyClass
-		//Actually it returns an RValue object with m_data equal to the sum of the m_data properties from both invoker object and its operand
-		MyClass operator+(const MyClass& _A)
-		{
-			MyClass result;	
-			result.m_data=m_data+_A.m_data;
-			cout<<"Addition Operator invoked"<<endl;
-			return result;
-		}
-
-		//simple getter method
-		int data() const {return m_data;}
-	private:
-		int m_data;
-};
-
 //Two overloaded methods to distinguish RValue and LValue integer arguments:
 //You can comment any of the methods and recompile using g++ to check what happeds according to the concepts
 
@@ -118,6 +75,9 @@ int main()
 	func(b);
 	func(a+MyClass(4));
 	func(a);
+	//in LIFECYCLE_TRACE_RING mode the constructor/assignment messages were buffered: print them now
+	lifecycle::dump();
+
 	return 0;
 }
 
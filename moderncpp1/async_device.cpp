@@ -0,0 +1,105 @@
+#include "async_device.h"
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AsyncDevice::AsyncDevice(Reactor& t_reactor,Device& t_device,int t_fd)
+    :m_reactor{t_reactor},m_device{t_device},m_fd{t_fd},m_is_socket{false}
+{
+    struct stat info;
+    int flags = t_fd<0 ? -1 : ::fcntl(t_fd,F_GETFL);
+    if(flags<0 || ::fcntl(t_fd,F_SETFL,flags|O_NONBLOCK)<0 || ::fstat(t_fd,&info)<0)
+    {
+        int error = t_fd<0 ? EBADF : errno;
+        if(t_fd>=0)
+            ::close(t_fd);
+        throw std::system_error(error,std::generic_category(),"AsyncDevice: cannot use descriptor");
+    }
+    m_is_socket = S_ISSOCK(info.st_mode);
+    m_reactor.watch(m_fd);
+}
+
+AsyncDevice::~AsyncDevice()
+{
+    m_reactor.unwatch(m_fd);
+    ::close(m_fd);
+}
+
+bool AsyncDevice::ReadOperation::perform()
+{
+    ssize_t result;
+    do
+    {
+        result = ::read(m_device.m_fd,m_data,m_count);
+    }while(result<0 && errno==EINTR);
+    if(result>=0)
+    {
+        m_done = static_cast<DATA_SIZE>(result);
+        return true;
+    }
+    if(errno==EAGAIN || errno==EWOULDBLOCK)
+        return false;
+    m_error = errno;
+    return true;
+}
+
+bool AsyncDevice::ReadOperation::await_ready()
+{
+    return m_count==0 || perform();
+}
+
+void AsyncDevice::ReadOperation::await_suspend(std::coroutine_handle<> t_awaiting)
+{
+    continuation = t_awaiting;
+    m_device.m_reactor.waitReadable(m_device.m_fd,*this);
+}
+
+DATA_SIZE AsyncDevice::ReadOperation::await_resume()
+{
+    if(m_error)
+        throw std::system_error(m_error,std::generic_category(),"AsyncDevice: read");
+    return m_done;
+}
+
+bool AsyncDevice::WriteOperation::perform()
+{
+    while(m_done<m_count)
+    {
+        ssize_t result = m_device.m_is_socket
+                ? ::send(m_device.m_fd,m_data+m_done,m_count-m_done,MSG_NOSIGNAL)
+                : ::write(m_device.m_fd,m_data+m_done,m_count-m_done);
+        if(result>=0)
+        {
+            m_done += static_cast<DATA_SIZE>(result);
+            continue;
+        }
+        if(errno==EAGAIN || errno==EWOULDBLOCK)
+            return false;
+        if(errno==EINTR)
+            continue;
+        m_error = errno;
+        return true;
+    }
+    return true;
+}
+
+bool AsyncDevice::WriteOperation::await_ready()
+{
+    return perform();
+}
+
+void AsyncDevice::WriteOperation::await_suspend(std::coroutine_handle<> t_awaiting)
+{
+    continuation = t_awaiting;
+    m_device.m_reactor.waitWritable(m_device.m_fd,*this);
+}
+
+DATA_SIZE AsyncDevice::WriteOperation::await_resume()
+{
+    if(m_error)
+        throw std::system_error(m_error,std::generic_category(),"AsyncDevice: write");
+    return m_done;
+}
@@ -0,0 +1,77 @@
+#ifndef ASYNC_DEVICE_H
+#define ASYNC_DEVICE_H
+
+#include <coroutine>
+#include "device.h"
+#include "reactor.h"
+
+//A Device backed by a file descriptor (character device, pipe, socket...), read and written from coroutines:
+//    DATA_SIZE n = co_await port.read(buffer,sizeof(buffer));
+//    co_await port.write(buffer,n);
+//The descriptor is switched to non-blocking mode: an operation first tries the syscall and only suspends
+//on EAGAIN, until the reactor reports the descriptor ready. Operations live in the awaiting coroutine frame,
+//so an I/O costs no allocation. One read and one write may be pending at a time, both on the reactor thread.
+//The Device is only the identity of the port (id, type, status): the bytes go straight between the caller's
+//buffer and the descriptor, the device ring buffer is not used. Each end of a connection has its own Device.
+class AsyncDevice{
+public:
+    //takes ownership of t_fd, which is closed with the AsyncDevice; t_device must outlive it
+    AsyncDevice(Reactor& t_reactor,Device& t_device,int t_fd);
+    AsyncDevice(const AsyncDevice&)=delete;
+    AsyncDevice& operator=(const AsyncDevice&)=delete;
+    //no operation may be pending any more
+    ~AsyncDevice();
+
+    class ReadOperation final : public IoOperation{
+    public:
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> t_awaiting);
+        //bytes read (at least one), 0 at end of stream; throws std::system_error on failure
+        DATA_SIZE await_resume();
+        bool perform() override;
+    private:
+        friend class AsyncDevice;
+        ReadOperation(AsyncDevice& t_device,BYTE* t_data,DATA_SIZE t_count)
+            :m_device{t_device},m_data{t_data},m_count{t_count}{}
+        AsyncDevice& m_device;
+        BYTE* m_data;
+        DATA_SIZE m_count;
+        DATA_SIZE m_done=0;
+        int m_error=0;
+    };
+
+    class WriteOperation final : public IoOperation{
+    public:
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> t_awaiting);
+        //completes once every byte is written; throws std::system_error on failure
+        DATA_SIZE await_resume();
+        bool perform() override;
+    private:
+        friend class AsyncDevice;
+        WriteOperation(AsyncDevice& t_device,const BYTE* t_data,DATA_SIZE t_count)
+            :m_device{t_device},m_data{t_data},m_count{t_count}{}
+        AsyncDevice& m_device;
+        const BYTE* m_data;
+        DATA_SIZE m_count;
+        DATA_SIZE m_done=0;
+        int m_error=0;
+    };
+
+    //reads whatever is available, up to t_count bytes
+    ReadOperation read(BYTE* t_data,DATA_SIZE t_count) {return ReadOperation(*this,t_data,t_count);}
+    //writes all t_count bytes
+    WriteOperation write(const BYTE* t_data,DATA_SIZE t_count) {return WriteOperation(*this,t_data,t_count);}
+
+    Device& device() {return m_device;}
+    const Device& device() const {return m_device;}
+    int fd() const {return m_fd;}
+
+private:
+    Reactor& m_reactor;
+    Device& m_device;
+    int m_fd;
+    bool m_is_socket;   //sockets are written with send(MSG_NOSIGNAL): a closed peer is an error, not a SIGPIPE
+};
+
+#endif // ASYNC_DEVICE_H
@@ -0,0 +1,34 @@
+#include "buffer_compressor.h"
+
+BufferCompressor::BufferCompressor(std::chrono::steady_clock::duration t_idle_time):m_idle_time{t_idle_time}
+{
+}
+
+std::size_t BufferCompressor::sweep(DeviceRegistry& t_registry,std::chrono::steady_clock::time_point t_now)
+{
+    const std::uint64_t sweep = ++m_sweeps;
+    std::size_t compressed = 0;
+    t_registry.forEachMatch(DeviceQuery().status(IDLE).status(STOPPED),[&](Device& t_device){
+        const std::uint32_t version = t_device.getStatusVersion();
+        auto inserted = m_idle_devices.emplace(t_device.getId(),IdleDevice{version,t_now,false,sweep});
+        IdleDevice& idle = inserted.first->second;
+        idle.sweep = sweep;
+        //a status change, or an access that decompressed the buffer, restarts the idle time
+        if(idle.status_version!=version || (idle.compressed && !t_device.isBufferCompressed()))
+            idle = IdleDevice{version,t_now,false,sweep};
+        if(!idle.compressed && t_now-idle.since>=m_idle_time && t_device.compressBuffer())
+        {
+            idle.compressed = true;
+            ++compressed;
+        }
+    });
+    //forget the devices that are no longer idle (or no longer registered)
+    for(auto it=m_idle_devices.begin();it!=m_idle_devices.end();)
+    {
+        if(it->second.sweep!=sweep)
+            it = m_idle_devices.erase(it);
+        else
+            ++it;
+    }
+    return compressed;
+}
@@ -0,0 +1,39 @@
+#ifndef BUFFER_COMPRESSOR_H
+#define BUFFER_COMPRESSOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "device_registry.h"
+
+//Opt-in compression of the buffers of idle devices.
+//A device is idle while it is IDLE or STOPPED; once it has stayed so (same status version) for at least
+//t_idle_time, sweep() compresses its buffer in place (Device::compressBuffer). The next read or write
+//decompresses it. A device decompressed that way counts as active again: its idle time restarts.
+//Call sweep() periodically from the thread that owns the registry. Producer and consumer threads may keep
+//using the devices: a buffer being read or written at the time is skipped and tried again on the next sweep.
+class BufferCompressor{
+public:
+    explicit BufferCompressor(std::chrono::steady_clock::duration t_idle_time);
+
+    //compresses the buffers of the devices idle for long enough, returns how many were compressed
+    std::size_t sweep(DeviceRegistry& t_registry,std::chrono::steady_clock::time_point t_now=std::chrono::steady_clock::now());
+
+    //bytes saved, decompression latency...: see Device::compressionStats
+    static BufferCompressionStats stats() {return Device::compressionStats();}
+
+private:
+    struct IdleDevice{
+        std::uint32_t status_version;
+        std::chrono::steady_clock::time_point since;
+        bool compressed;        //by this compressor
+        std::uint64_t sweep;    //last sweep that saw the device idle
+    };
+
+    std::chrono::steady_clock::duration m_idle_time;
+    std::unordered_map<int,IdleDevice> m_idle_devices;
+    std::uint64_t m_sweeps=0;
+};
+
+#endif // BUFFER_COMPRESSOR_H
@@ -0,0 +1,176 @@
+#include "concurrent_device_registry.h"
+
+//average chain length that triggers doubling the bucket count of a shard
+static const std::size_t MAX_LOAD_FACTOR = 2;
+
+static std::size_t roundUpToPowerOfTwo(std::size_t t_value)
+{
+    std::size_t result = 1;
+    while(result<t_value)
+        result <<= 1;
+    return result;
+}
+
+ConcurrentDeviceRegistry::Table::Table(std::size_t t_bucket_count)
+    :bucket_count{t_bucket_count},buckets{new std::atomic<Link*>[t_bucket_count]}
+{
+    for(std::size_t i=0;i<bucket_count;++i)
+        buckets[i].store(nullptr,std::memory_order_relaxed);
+}
+
+ConcurrentDeviceRegistry::ConcurrentDeviceRegistry(std::size_t t_shard_count,std::size_t t_buckets_per_shard)
+    :m_shard_count{roundUpToPowerOfTwo(std::max<std::size_t>(t_shard_count,1))},m_shards{new Shard[m_shard_count]}
+{
+    const std::size_t bucket_count = roundUpToPowerOfTwo(std::max<std::size_t>(t_buckets_per_shard,1));
+    for(std::size_t s=0;s<m_shard_count;++s)
+        m_shards[s].table.store(new Table(bucket_count),std::memory_order_release);
+}
+
+//no other thread may use the registry any more: everything is freed directly
+ConcurrentDeviceRegistry::~ConcurrentDeviceRegistry()
+{
+    for(std::size_t s=0;s<m_shard_count;++s)
+    {
+        Table* table = m_shards[s].table.load(std::memory_order_acquire);
+        for(std::size_t b=0;b<table->bucket_count;++b)
+        {
+            Link* link = table->buckets[b].load(std::memory_order_relaxed);
+            while(link!=nullptr)
+            {
+                Link* next = link->next.load(std::memory_order_relaxed);
+                delete link->device;
+                delete link;
+                link = next;
+            }
+        }
+        delete table;
+    }
+}
+
+std::uint64_t ConcurrentDeviceRegistry::hash(int t_id)
+{
+    //Fibonacci hashing: consecutive ids end up far apart
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(t_id))*0x9E3779B97F4A7C15ull;
+}
+
+ConcurrentDeviceRegistry::Shard& ConcurrentDeviceRegistry::shardFor(std::uint64_t t_hash) const
+{
+    return m_shards[(t_hash>>56)&(m_shard_count-1)];
+}
+
+std::size_t ConcurrentDeviceRegistry::bucketFor(const Table& t_table,std::uint64_t t_hash)
+{
+    return (t_hash>>16)&(t_table.bucket_count-1);
+}
+
+bool ConcurrentDeviceRegistry::insert(Device* t_device)
+{
+    const int id = t_device->getId();
+    const std::uint64_t h = hash(id);
+    Shard& shard = shardFor(h);
+    std::lock_guard<std::mutex> lock(shard.writer_mutex);
+
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    std::atomic<Link*>& bucket = table->buckets[bucketFor(*table,h)];
+    for(Link* link=bucket.load(std::memory_order_relaxed);link!=nullptr;link=link->next.load(std::memory_order_relaxed))
+        if(link->id==id)
+            return false;
+
+    //the link is complete before it is published with a release store: readers never see it half built
+    Link* link = new Link{id,t_device,{bucket.load(std::memory_order_relaxed)}};
+    bucket.store(link,std::memory_order_release);
+    if(shard.count.fetch_add(1,std::memory_order_relaxed)+1>table->bucket_count*MAX_LOAD_FACTOR)
+        grow(shard);
+    return true;
+}
+
+bool ConcurrentDeviceRegistry::erase(int t_id)
+{
+    const std::uint64_t h = hash(t_id);
+    Shard& shard = shardFor(h);
+    std::lock_guard<std::mutex> lock(shard.writer_mutex);
+
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    std::atomic<Link*>* previous = &table->buckets[bucketFor(*table,h)];
+    for(Link* link=previous->load(std::memory_order_relaxed);link!=nullptr;link=link->next.load(std::memory_order_relaxed))
+    {
+        if(link->id==t_id)
+        {
+            //unlink: readers already standing on the link still find a valid next pointer
+            previous->store(link->next.load(std::memory_order_relaxed),std::memory_order_release);
+            shard.count.fetch_sub(1,std::memory_order_relaxed);
+            EpochManager::global().retire(link->device);
+            EpochManager::global().retire(link);
+            return true;
+        }
+        previous = &link->next;
+    }
+    return false;
+}
+
+Device* ConcurrentDeviceRegistry::find(int t_id) const
+{
+    const std::uint64_t h = hash(t_id);
+    const Table* table = shardFor(h).table.load(std::memory_order_acquire);
+    for(const Link* link=table->buckets[bucketFor(*table,h)].load(std::memory_order_acquire);link!=nullptr;
+        link=link->next.load(std::memory_order_acquire))
+        if(link->id==t_id)
+            return link->device;
+    return nullptr;
+}
+
+bool ConcurrentDeviceRegistry::setStatus(int t_id,DEVICE_STATUS t_status,StatusChange* t_change)
+{
+    EpochManager::Guard guard(EpochManager::global());
+    Device* device = find(t_id);
+    StatusChange change;
+    if(device==nullptr || !device->transitionTo(t_status,&change))
+        return false;
+    StatusNotifier* notifier = m_notifier.load(std::memory_order_acquire);
+    if(notifier)
+        notifier->publish(change);
+    if(t_change)
+        *t_change = change;
+    return true;
+}
+
+bool ConcurrentDeviceRegistry::contains(int t_id) const
+{
+    EpochManager::Guard guard(EpochManager::global());
+    return find(t_id)!=nullptr;
+}
+
+std::size_t ConcurrentDeviceRegistry::size() const
+{
+    std::size_t total = 0;
+    for(std::size_t s=0;s<m_shard_count;++s)
+        total += m_shards[s].count.load(std::memory_order_relaxed);
+    return total;
+}
+
+//called with the shard writer mutex held: builds a twice larger table with fresh links,
+//publishes it, and retires the old table and links (readers may still be walking them)
+void ConcurrentDeviceRegistry::grow(Shard& t_shard)
+{
+    Table* old_table = t_shard.table.load(std::memory_order_relaxed);
+    Table* new_table = new Table(old_table->bucket_count*2);
+    for(std::size_t b=0;b<old_table->bucket_count;++b)
+        for(Link* link=old_table->buckets[b].load(std::memory_order_relaxed);link!=nullptr;link=link->next.load(std::memory_order_relaxed))
+        {
+            std::atomic<Link*>& bucket = new_table->buckets[bucketFor(*new_table,hash(link->id))];
+            bucket.store(new Link{link->id,link->device,{bucket.load(std::memory_order_relaxed)}},std::memory_order_relaxed);
+        }
+    t_shard.table.store(new_table,std::memory_order_release);
+
+    for(std::size_t b=0;b<old_table->bucket_count;++b)
+    {
+        Link* link = old_table->buckets[b].load(std::memory_order_relaxed);
+        while(link!=nullptr)
+        {
+            Link* next = link->next.load(std::memory_order_relaxed);
+            EpochManager::global().retire(link);
+            link = next;
+        }
+    }
+    EpochManager::global().retire(old_table);
+}
@@ -0,0 +1,112 @@
+#ifndef CONCURRENT_DEVICE_REGISTRY_H
+#define CONCURRENT_DEVICE_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "device.h"
+#include "epoch_reclamation.h"
+#include "status_notifier.h"
+
+//Device registry for many threads creating, looking up and retiring devices at the same time.
+//  - ids come from the atomic Device::next_device_id
+//  - devices are spread over shards, each shard is a hash table with its own writer mutex
+//  - lookups never lock: they walk atomic bucket chains inside an EpochManager guard, and removed
+//    devices (and replaced tables) are only freed when no reader can still see them
+//A looked-up device may be read concurrently by many threads: only use its thread-safe members.
+class ConcurrentDeviceRegistry{
+public:
+    explicit ConcurrentDeviceRegistry(std::size_t t_shard_count=64,std::size_t t_buckets_per_shard=256);
+    ConcurrentDeviceRegistry(const ConcurrentDeviceRegistry&)=delete;
+    ConcurrentDeviceRegistry& operator=(const ConcurrentDeviceRegistry&)=delete;
+    ~ConcurrentDeviceRegistry();
+
+    //creates the device with any Device constructor and returns its id
+    //throws std::invalid_argument if the id is already registered
+    template<typename... Args>
+    int emplace(Args&&... t_args)
+    {
+        auto device = std::make_unique<Device>(std::forward<Args>(t_args)...);
+        const int id = device->getId();
+        if(!insert(device.get()))
+            throw std::invalid_argument("ConcurrentDeviceRegistry: duplicate device id "+std::to_string(id));
+        device.release();
+        return id;
+    }
+
+    bool erase(int t_id);
+
+    //lock-free lookup: calls t_reader(const Device&) while the device is guaranteed to stay alive
+    template<typename Reader>
+    bool read(int t_id,Reader&& t_reader) const
+    {
+        EpochManager::Guard guard(EpochManager::global());
+        const Device* device = find(t_id);
+        if(device==nullptr)
+            return false;
+        t_reader(*device);
+        return true;
+    }
+
+    //lock-free status change (Device::transitionTo), false for an unknown id or a transition not allowed
+    bool setStatus(int t_id,DEVICE_STATUS t_status,StatusChange* t_change=nullptr);
+    //every status change made through setStatus is published to t_notifier (nullptr: none)
+    void setStatusNotifier(StatusNotifier* t_notifier) {m_notifier.store(t_notifier,std::memory_order_release);}
+
+    bool contains(int t_id) const;
+
+    //lock-free walk over every device (devices added or removed meanwhile may or may not be seen)
+    template<typename Visitor>
+    void forEach(Visitor&& t_visitor) const
+    {
+        EpochManager::Guard guard(EpochManager::global());
+        for(std::size_t s=0;s<m_shard_count;++s)
+        {
+            const Table* table = m_shards[s].table.load(std::memory_order_acquire);
+            for(std::size_t b=0;b<table->bucket_count;++b)
+                for(const Link* link=table->buckets[b].load(std::memory_order_acquire);link!=nullptr;
+                    link=link->next.load(std::memory_order_acquire))
+                    t_visitor(static_cast<const Device&>(*link->device));
+        }
+    }
+
+    std::size_t size() const;
+
+private:
+    //chain element: the device pointer plus the next link of the bucket
+    struct Link{
+        int id;
+        Device* device;
+        std::atomic<Link*> next;
+    };
+
+    struct Table{
+        explicit Table(std::size_t t_bucket_count);
+        std::size_t bucket_count;       //power of two
+        std::unique_ptr<std::atomic<Link*>[]> buckets;
+    };
+
+    struct alignas(64) Shard{
+        std::mutex writer_mutex;
+        std::atomic<Table*> table{nullptr};
+        std::atomic<std::size_t> count{0};
+    };
+
+    static std::uint64_t hash(int t_id);
+    Shard& shardFor(std::uint64_t t_hash) const;
+    static std::size_t bucketFor(const Table& t_table,std::uint64_t t_hash);
+
+    bool insert(Device* t_device);
+    Device* find(int t_id) const;
+    void grow(Shard& t_shard);
+
+    std::size_t m_shard_count;
+    std::unique_ptr<Shard[]> m_shards;
+    std::atomic<StatusNotifier*> m_notifier{nullptr};
+};
+
+#endif // CONCURRENT_DEVICE_REGISTRY_H
@@ -1,4 +1,15 @@
 #include "device.h"
+#include "../Common/latency_histogram.h"
+#include "lz_codec.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 //nested standard container initialization
 const static std::map<DEVICE_STATUS,std::string> device_status_labels={
@@ -17,33 +28,474 @@ const static std::map<DEVICE_TYPE,const std::string> device_type_labels={
     {PRINTER,"PRINTER"}
 };
 
-int Device::next_device_id=1;
+std::atomic<int> Device::next_device_id{1};
 
+//idle buffer compression figures
+static std::atomic<std::uint64_t> compressed_buffers{0};
+static std::atomic<std::uint64_t> compression_bytes_saved{0};
+static std::atomic<std::uint64_t> compressions{0};
+//decompressions happen once per wake-up of a device: a lock around the histogram is cheap enough
+static std::mutex decompression_mutex;
+static latency::LatencyHistogram decompression_latency;
+
+static void recordPacked(std::size_t t_saved)
+{
+    compressed_buffers.fetch_add(1,std::memory_order_relaxed);
+    compression_bytes_saved.fetch_add(t_saved,std::memory_order_relaxed);
+    compressions.fetch_add(1,std::memory_order_relaxed);
+}
+
+//a compressed buffer decompressed or destroyed
+static void recordUnpacked(std::size_t t_saved)
+{
+    compressed_buffers.fetch_sub(1,std::memory_order_relaxed);
+    compression_bytes_saved.fetch_sub(t_saved,std::memory_order_relaxed);
+}
+
+struct Device::PackedBuffer{
+    std::uint32_t data_size;
+    std::uint32_t packed_size;      //equal to data_size: the bytes are stored as they are
+
+    BYTE* data(){return reinterpret_cast<BYTE*>(this+1);}
+    const BYTE* data() const {return reinterpret_cast<const BYTE*>(this+1);}
+    bool isStored() const {return packed_size==data_size;}
+};
+
+
+Device::~Device()
+{
+    releaseBuffer();
+    releaseColdData();
+}
 
 Device& Device::operator=(Device&& t_source)
 {
-    std::cout<<">>Inside Move Assignment Operator."<<std::endl;
-    delete [] m_buffer;
+    LATENCY_SCOPE("Device::operator=");
+    LIFECYCLE_TRACE(this,">>Inside Move Assignment Operator.");
+    if(this==&t_source)
+        return *this;
+    if(m_registry_owned || t_source.m_registry_owned)
+        throw std::logic_error("Device: a registry-owned device cannot be move-assigned, erase and emplace instead");
+
+    releaseBuffer();
     m_buffer_capacity = t_source.m_buffer_capacity;
-    m_buffer = t_source.m_buffer;
-    t_source.m_buffer = nullptr;
+    if(*m_resource==*t_source.m_resource)
+    {
+        //same memory resource: simply steal the buffer (the ring indexes come along in its header),
+        //compressed or not
+        if((t_source.m_buffer_state.load(std::memory_order_relaxed)&BUFFER_STATE_MASK)==BUFFER_PACKED)
+        {
+            m_packed = t_source.m_packed;
+            m_buffer_state.store(BUFFER_PACKED,std::memory_order_relaxed);
+        }
+        else
+            m_ring = t_source.m_ring;
+        t_source.m_ring = nullptr;
+        t_source.m_buffer_state.store(BUFFER_PLAIN,std::memory_order_relaxed);
+    }
+    else
+    {
+        t_source.unpackBuffer();
+        //a buffer must go back to the resource it came from, so different resources force a copy
+        //(the buffered bytes are copied out of the ring in order, starting at position 0)
+        m_ring = allocateBuffer(m_buffer_capacity);
+        if(m_ring!=nullptr)
+        {
+            const DATA_SIZE data_size = t_source.read_n(m_ring->data(),m_buffer_capacity);
+            m_ring->write_index.store(data_size,std::memory_order_relaxed);
+            m_ring->cached_write_index = data_size;
+        }
+        t_source.releaseBuffer();
+    }
     t_source.m_buffer_capacity=0;
 
+    //the event log follows the device: its store entry is handed over to this object
+    releaseColdData();
+    if(t_source.m_has_cold_data)
+    {
+        DeviceColdStore::global().move(&t_source,this);
+        m_has_cold_data = true;
+        t_source.m_has_cold_data = false;
+    }
+
     m_type = t_source.m_type;
-    m_status = t_source.m_status;
-    m_comment = t_source.m_comment;
-    m_buffer_data_size = t_source.m_buffer_data_size;
+    m_status.store(t_source.m_status.load(std::memory_order_relaxed),std::memory_order_relaxed);
 
     t_source.m_type = GPIO;
-    t_source.m_comment="";
-    t_source.m_status = STOPPED;
+    t_source.m_status.store(packStatus(STOPPED,0),std::memory_order_relaxed);
 
     return *this;
 }
 
-void Device::addCommentToDevice(std::string t_comment)
+bool Device::write(BYTE t_byte)
+{
+    return write_n(&t_byte,1)==1;
+}
+
+bool Device::read(BYTE& t_byte)
+{
+    return read_n(&t_byte,1)==1;
+}
+
+DATA_SIZE Device::write_n(const BYTE* t_data,DATA_SIZE t_count)
+{
+    while(!enterRing())
+        unpackBuffer();
+    const DATA_SIZE count = writeRing(t_data,t_count);
+    leaveRing();
+    return count;
+}
+
+DATA_SIZE Device::writeRing(const BYTE* t_data,DATA_SIZE t_count)
+{
+    if(m_ring==nullptr)
+        return 0;
+    RingHeader& ring = *m_ring;
+    const DATA_SIZE capacity = m_buffer_capacity;
+    const DATA_SIZE write_index = ring.write_index.load(std::memory_order_relaxed);
+    //look at the consumer index (another cache line) only when the cached value says the ring is full
+    DATA_SIZE free_space = capacity-(write_index-ring.cached_read_index);
+    if(free_space<t_count)
+    {
+        ring.cached_read_index = ring.read_index.load(std::memory_order_acquire);
+        free_space = capacity-(write_index-ring.cached_read_index);
+    }
+    const DATA_SIZE count = std::min(t_count,free_space);
+    if(count==0)
+        return 0;
+
+    //at most two copies: up to the end of the buffer, then the wrapped part at the beginning
+    BYTE* buffer = ring.data();
+    const DATA_SIZE position = write_index%capacity;
+    const DATA_SIZE first_part = std::min(count,capacity-position);
+    std::copy(t_data,t_data+first_part,buffer+position);
+    std::copy(t_data+first_part,t_data+count,buffer);
+    ring.write_index.store(write_index+count,std::memory_order_release);
+    return count;
+}
+
+DATA_SIZE Device::read_n(BYTE* t_data,DATA_SIZE t_count)
+{
+    while(!enterRing())
+        unpackBuffer();
+    const DATA_SIZE count = readRing(t_data,t_count);
+    leaveRing();
+    return count;
+}
+
+DATA_SIZE Device::readRing(BYTE* t_data,DATA_SIZE t_count)
+{
+    if(m_ring==nullptr)
+        return 0;
+    RingHeader& ring = *m_ring;
+    const DATA_SIZE capacity = m_buffer_capacity;
+    const DATA_SIZE read_index = ring.read_index.load(std::memory_order_relaxed);
+    DATA_SIZE available = ring.cached_write_index-read_index;
+    if(available<t_count)
+    {
+        ring.cached_write_index = ring.write_index.load(std::memory_order_acquire);
+        available = ring.cached_write_index-read_index;
+    }
+    const DATA_SIZE count = std::min(t_count,available);
+    if(count==0)
+        return 0;
+
+    const BYTE* buffer = ring.data();
+    const DATA_SIZE position = read_index%capacity;
+    const DATA_SIZE first_part = std::min(count,capacity-position);
+    std::copy(buffer+position,buffer+position+first_part,t_data);
+    std::copy(buffer,buffer+(count-first_part),t_data+first_part);
+    ring.read_index.store(read_index+count,std::memory_order_release);
+    return count;
+}
+
+DATA_SIZE Device::peek_n(BYTE* t_data,DATA_SIZE t_count) const
+{
+    //the buffer may be compressed or decompressed between the two checks: try again
+    for(;;)
+    {
+        if(enterRing())
+        {
+            const DATA_SIZE count = peekRing(t_data,t_count);
+            leaveRing();
+            return count;
+        }
+        if(!lockPacked())
+            continue;
+        //decodes only the bytes asked for, the device stays compressed
+        DATA_SIZE count = 0;
+        try
+        {
+            if(m_packed!=nullptr)
+            {
+                count = std::min<DATA_SIZE>(t_count,m_packed->data_size);
+                if(m_packed->isStored())
+                    std::memcpy(t_data,m_packed->data(),count);
+                else
+                    LzCodec::decompress(m_packed->data(),m_packed->packed_size,t_data,count);
+            }
+        }
+        catch(...)
+        {
+            unlockPacked();
+            throw;
+        }
+        unlockPacked();
+        return count;
+    }
+}
+
+DATA_SIZE Device::peekRing(BYTE* t_data,DATA_SIZE t_count) const
+{
+    if(m_ring==nullptr)
+        return 0;
+    const RingHeader& ring = *m_ring;
+    const DATA_SIZE capacity = m_buffer_capacity;
+    const DATA_SIZE read_index = ring.read_index.load(std::memory_order_relaxed);
+    const DATA_SIZE count = std::min(t_count,ring.write_index.load(std::memory_order_acquire)-read_index);
+    const BYTE* buffer = ring.data();
+    const DATA_SIZE position = read_index%capacity;
+    const DATA_SIZE first_part = std::min(count,capacity-position);
+    std::copy(buffer+position,buffer+position+first_part,t_data);
+    std::copy(buffer,buffer+(count-first_part),t_data+first_part);
+    return count;
+}
+
+DATA_SIZE Device::getDataSize() const
+{
+    for(;;)
+    {
+        if(enterRing())
+        {
+            const DATA_SIZE size = ringDataSize();
+            leaveRing();
+            return size;
+        }
+        if(lockPacked())
+        {
+            const DATA_SIZE size = m_packed!=nullptr ? m_packed->data_size : 0;
+            unlockPacked();
+            return size;
+        }
+    }
+}
+
+DATA_SIZE Device::ringDataSize() const
+{
+    if(m_ring==nullptr)
+        return 0;
+    const DATA_SIZE read_index = m_ring->read_index.load(std::memory_order_acquire);
+    return m_ring->write_index.load(std::memory_order_acquire)-read_index;
+}
+
+DATA_SIZE Device::getBufferCapacity() const
+{
+    return m_buffer_capacity;
+}
+
+std::size_t Device::bufferAllocationSize(DATA_SIZE t_capacity)
+{
+    return t_capacity==0 ? 0 : sizeof(RingHeader)+t_capacity;
+}
+
+std::uint32_t Device::checkedCapacity(DATA_SIZE t_capacity)
+{
+    if(t_capacity>UINT32_MAX)
+        throw std::length_error("Device: buffer capacity is limited to 4 GiB");
+    return static_cast<std::uint32_t>(t_capacity);
+}
+
+Device::RingHeader* Device::allocateBuffer(DATA_SIZE t_size)
+{
+    if(t_size==0)
+        return nullptr;
+    return new(m_resource->allocate(bufferAllocationSize(t_size),BUFFER_ALIGNMENT)) RingHeader;
+}
+
+void Device::releaseBuffer()
+{
+    //no access in progress here (destruction, move): the state is PLAIN or PACKED, without access count
+    if((m_buffer_state.load(std::memory_order_relaxed)&BUFFER_STATE_MASK)==BUFFER_PACKED)
+    {
+        recordUnpacked(packedSavings());
+        if(m_packed!=nullptr)
+            m_resource->deallocate(m_packed,sizeof(PackedBuffer)+m_packed->packed_size,alignof(PackedBuffer));
+        m_buffer_state.store(BUFFER_PLAIN,std::memory_order_relaxed);
+    }
+    else if(m_ring!=nullptr)
+    {
+        m_ring->~RingHeader();
+        m_resource->deallocate(m_ring,bufferAllocationSize(m_buffer_capacity),BUFFER_ALIGNMENT);
+    }
+    m_ring = nullptr;
+}
+
+bool Device::compressBuffer()
+{
+    //claims the ring: only succeeds when it is plain and nobody is reading or writing it. Accesses starting
+    //meanwhile see BUSY and wait in unpackBuffer until the buffer is packed, then decompress it.
+    std::uint8_t expected = BUFFER_PLAIN;
+    if(!m_buffer_state.compare_exchange_strong(expected,BUFFER_BUSY,std::memory_order_acquire,std::memory_order_relaxed))
+        return false;
+    if(m_ring==nullptr)
+    {
+        m_buffer_state.fetch_sub(BUFFER_BUSY-BUFFER_PLAIN,std::memory_order_release);
+        return false;
+    }
+    PackedBuffer* packed = nullptr;
+    try
+    {
+        //the ring content in order, then room for its compressed form (reused by the next compressions on this thread)
+        const DATA_SIZE data_size = ringDataSize();
+        thread_local std::vector<BYTE> scratch;
+        scratch.resize(2*data_size);
+        BYTE* plain = scratch.data();
+        BYTE* compressed = plain+data_size;
+        peekRing(plain,data_size);
+        if(data_size>0)
+        {
+            //bytes that do not compress are kept as they are: the ring header and the free space are still saved
+            std::size_t packed_size = LzCodec::compress(plain,data_size,compressed,data_size-1);
+            const BYTE* packed_bytes = compressed;
+            if(packed_size==0)
+            {
+                packed_size = data_size;
+                packed_bytes = plain;
+            }
+            void* memory = m_resource->allocate(sizeof(PackedBuffer)+packed_size,alignof(PackedBuffer));
+            packed = ::new (memory) PackedBuffer{static_cast<std::uint32_t>(data_size),static_cast<std::uint32_t>(packed_size)};
+            std::memcpy(packed->data(),packed_bytes,packed_size);
+        }
+    }
+    catch(...)
+    {
+        m_buffer_state.fetch_sub(BUFFER_BUSY-BUFFER_PLAIN,std::memory_order_release);
+        throw;
+    }
+    m_ring->~RingHeader();
+    m_resource->deallocate(m_ring,bufferAllocationSize(m_buffer_capacity),BUFFER_ALIGNMENT);
+    m_packed = packed;
+    recordPacked(packedSavings());
+    m_buffer_state.fetch_sub(BUFFER_BUSY-BUFFER_PACKED,std::memory_order_release);
+    return true;
+}
+
+bool Device::isBufferCompressed() const
+{
+    return (m_buffer_state.load(std::memory_order_acquire)&BUFFER_STATE_MASK)!=BUFFER_PLAIN;
+}
+
+bool Device::enterRing() const
+{
+    const std::uint8_t state = m_buffer_state.fetch_add(BUFFER_ACCESS,std::memory_order_acquire);
+    if((state&BUFFER_STATE_MASK)==BUFFER_PLAIN)
+        return true;
+    m_buffer_state.fetch_sub(BUFFER_ACCESS,std::memory_order_relaxed);
+    return false;
+}
+
+void Device::leaveRing() const
+{
+    m_buffer_state.fetch_sub(BUFFER_ACCESS,std::memory_order_release);
+}
+
+bool Device::lockPacked() const
+{
+    std::uint8_t state = m_buffer_state.load(std::memory_order_acquire);
+    for(;;)
+    {
+        //the access count of the other bits belongs to threads about to back off: kept as it is
+        if((state&BUFFER_STATE_MASK)==BUFFER_PLAIN)
+            return false;
+        if((state&BUFFER_STATE_MASK)==BUFFER_PACKED)
+        {
+            if(m_buffer_state.compare_exchange_weak(state,state+(BUFFER_BUSY-BUFFER_PACKED),std::memory_order_acquire,std::memory_order_acquire))
+                return true;
+        }
+        else
+        {
+            //another thread is on it: short wait, a (de)compression is a few microseconds at most
+            std::this_thread::yield();
+            state = m_buffer_state.load(std::memory_order_acquire);
+        }
+    }
+}
+
+void Device::unlockPacked() const
+{
+    m_buffer_state.fetch_sub(BUFFER_BUSY-BUFFER_PACKED,std::memory_order_release);
+}
+
+void Device::unpackBuffer()
+{
+    if(!lockPacked())
+        return;     //already done by the other side
+    LATENCY_SCOPE("Device buffer decompression");
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t saved = packedSavings();
+    RingHeader* ring = nullptr;
+    try
+    {
+        ring = allocateBuffer(m_buffer_capacity);
+        if(m_packed!=nullptr)
+        {
+            const DATA_SIZE data_size = m_packed->data_size;
+            if(m_packed->isStored())
+                std::memcpy(ring->data(),m_packed->data(),data_size);
+            else
+                LzCodec::decompress(m_packed->data(),m_packed->packed_size,ring->data(),data_size);
+            ring->write_index.store(data_size,std::memory_order_relaxed);
+            ring->cached_write_index = data_size;
+        }
+    }
+    catch(...)
+    {
+        if(ring!=nullptr)
+            m_resource->deallocate(ring,bufferAllocationSize(m_buffer_capacity),BUFFER_ALIGNMENT);
+        unlockPacked();
+        throw;
+    }
+    if(m_packed!=nullptr)
+        m_resource->deallocate(m_packed,sizeof(PackedBuffer)+m_packed->packed_size,alignof(PackedBuffer));
+    m_ring = ring;
+    recordUnpacked(saved);
+    m_buffer_state.fetch_sub(BUFFER_BUSY-BUFFER_PLAIN,std::memory_order_release);
+    const auto elapsed = std::chrono::steady_clock::now()-start;
+    std::lock_guard<std::mutex> lock(decompression_mutex);
+    decompression_latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+BufferCompressionStats Device::compressionStats()
+{
+    BufferCompressionStats stats;
+    stats.compressed_buffers = compressed_buffers.load(std::memory_order_relaxed);
+    stats.bytes_saved = compression_bytes_saved.load(std::memory_order_relaxed);
+    stats.compressions = compressions.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(decompression_mutex);
+    stats.decompressions = decompression_latency.count();
+    stats.decompression_mean_ns = decompression_latency.mean();
+    stats.decompression_p50_ns = decompression_latency.valueAtPercentile(50);
+    stats.decompression_p99_ns = decompression_latency.valueAtPercentile(99);
+    stats.decompression_max_ns = decompression_latency.max();
+    return stats;
+}
+
+std::size_t Device::packedSavings() const
+{
+    return bufferAllocationSize(m_buffer_capacity)-(m_packed!=nullptr ? sizeof(PackedBuffer)+m_packed->packed_size : 0);
+}
+
+void Device::releaseColdData()
+{
+    if(m_has_cold_data)
+        DeviceColdStore::global().erase(this);
+    m_has_cold_data = false;
+}
+
+void Device::addCommentToDevice(std::string_view t_comment)
 {
-    m_comment += "\n"+t_comment;
+    DeviceColdStore::global().record(this,t_comment);
+    m_has_cold_data = true;
 }
 
 int Device::getId() const
@@ -51,26 +503,105 @@ int Device::getId() const
     return m_id;
 }
 
-std::string Device::getComment() const
+DeviceEventLog Device::getEvents() const
 {
-    return  m_comment;
+    //asks the store even without m_has_cold_data: the flag belongs to the recording thread
+    return DeviceColdStore::global().events(this);
 }
 
 DEVICE_STATUS Device::getStatusCode() const
 {
-     return m_status;
+     return static_cast<DEVICE_STATUS>(m_status.load(std::memory_order_acquire) & 0xff);
+}
+
+std::uint32_t Device::getStatusVersion() const
+{
+    return m_status.load(std::memory_order_acquire)>>8;
+}
+
+bool Device::isAllowedTransition(DEVICE_STATUS t_from,DEVICE_STATUS t_to)
+{
+    //bit t_to of allowed_targets[t_from]
+    static const unsigned allowed_targets[DEVICE_STATUS_COUNT]={
+        /*READY*/    1u<<IDLE | 1u<<FAULT | 1u<<STOPPED,
+        /*STARTING*/ 1u<<READY | 1u<<FAULT | 1u<<STOPPED,
+        /*IDLE*/     1u<<READY | 1u<<FAULT | 1u<<STOPPED,
+        /*FAULT*/    1u<<STARTING | 1u<<STOPPED,
+        /*STOPPED*/  1u<<STARTING
+    };
+    return (allowed_targets[t_from]>>t_to & 1u)!=0;
+}
+
+bool Device::transitionTo(DEVICE_STATUS t_status,StatusChange* t_change)
+{
+    if(m_registry_owned)
+        throw std::logic_error("Device: the status of a registry-owned device changes through DeviceRegistry::setStatus");
+    return applyTransition(t_status,t_change);
+}
+
+bool Device::applyTransition(DEVICE_STATUS t_status,StatusChange* t_change)
+{
+    std::uint32_t current = m_status.load(std::memory_order_acquire);
+    for(;;)
+    {
+        const DEVICE_STATUS from = static_cast<DEVICE_STATUS>(current & 0xff);
+        if(from==t_status)
+        {
+            if(t_change)
+                *t_change = StatusChange{m_id,from,from,current>>8,0};
+            return true;
+        }
+        if(!isAllowedTransition(from,t_status))
+            return false;
+        const std::uint32_t desired = packStatus(t_status,(current>>8)+1);
+        //on failure current is reloaded and the rule is checked again against the newer status
+        if(m_status.compare_exchange_weak(current,desired,std::memory_order_acq_rel,std::memory_order_acquire))
+        {
+            if(t_change)
+                *t_change = StatusChange{m_id,from,t_status,desired>>8,1};
+            return true;
+        }
+    }
+}
+
+DEVICE_TYPE Device::getTypeCode() const
+{
+    return static_cast<DEVICE_TYPE>(m_type);
+}
+
+const std::string& Device::getStatusLabel() const
+{
+    LATENCY_SCOPE("Device::getStatusLabel");
+    return statusLabel(getStatusCode());
+}
+
+const std::string& Device::getTypeLabel() const
+{
+    LATENCY_SCOPE("Device::getTypeLabel");
+    return typeLabel(getTypeCode());
 }
 
-const std::string Device::getStatusLabel() const
+const std::string& Device::statusLabel(DEVICE_STATUS t_status)
 {
     // device_status_labels is defined as "const std::map" so we use .at method here instead of operator[]
     // Because operator[] will add a node if key is not found (and its forbidden for a const map)
-    return device_status_labels.at(m_status);
+    return device_status_labels.at(t_status);
 }
 
-const std::string Device::getTypeLabel() const
+const std::string& Device::typeLabel(DEVICE_TYPE t_type)
 {
-    // device_status_labels is defined as "const std::map" so we use .at method here instead of operator[]
+    // device_type_labels is defined as "const std::map" so we use .at method here instead of operator[]
     // Because operator[] will add a node if key is not found (and its forbidden for a const map)
-    return device_type_labels.at(m_type);
+    return device_type_labels.at(t_type);
+}
+
+std::pmr::memory_resource* Device::getMemoryResource() const
+{
+    return m_resource;
+}
+
+std::unique_ptr<Device> createDevice(DEVICE_TYPE t_type,DEVICE_STATUS t_status)
+{
+    LATENCY_SCOPE("createDevice");
+    return std::make_unique<Device>(Device(t_type,t_status,32));
 }
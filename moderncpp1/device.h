@@ -4,69 +4,230 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "device_cold_store.h"
+#include "../Common/lifecycle_trace.h"
 
 typedef unsigned char BYTE;
 typedef unsigned long DATA_SIZE;
 
 const DATA_SIZE DEFAULT_BUFFER_CAPACITY = 32;
+//ring buffer indexes are padded to this size so the producer and consumer threads do not share a cache line
+const std::size_t CACHE_LINE_SIZE = 64;
 
 enum DEVICE_STATUS{READY=0,STARTING,IDLE,FAULT,STOPPED};
 enum DEVICE_TYPE{GPIO,KEYBOARD,MOUSE,DISPLAY,PRINTER};
+//number of enum values, the enums above are contiguous and start at 0
+const int DEVICE_STATUS_COUNT = STOPPED+1;
+const int DEVICE_TYPE_COUNT = PRINTER+1;
+
+//One status transition of a device. version counts the transitions of that device, so changes of one
+//device recorded by different threads can be put back in order.
+struct StatusChange{
+    int device_id;
+    DEVICE_STATUS from;
+    DEVICE_STATUS to;
+    std::uint32_t version;      //device status version after this change (24 bits, wraps around)
+    std::uint32_t transitions;  //1, or the number of changes merged into this one (see StatusNotifier)
+};
 
+//process-wide figures of the idle buffer compression (Device::compressBuffer, BufferCompressor)
+struct BufferCompressionStats{
+    std::uint64_t compressed_buffers=0;     //device buffers compressed right now
+    std::uint64_t bytes_saved=0;            //memory they give back to their resources right now
+    std::uint64_t compressions=0;
+    std::uint64_t decompressions=0;
+    //time to bring a buffer back (allocation + decode), in nanoseconds
+    double decompression_mean_ns=0;
+    std::uint64_t decompression_p50_ns=0;
+    std::uint64_t decompression_p99_ns=0;
+    std::uint64_t decompression_max_ns=0;
+};
 
-
+//Device layout (hot/cold split): the Device object only holds what scans over many devices read, packed
+//in 32 bytes (static_assert below). The ring buffer indexes live in a header in front of the buffer bytes,
+//in the same allocation, and the event log lives in the DeviceColdStore, keyed by the Device object.
 class Device{
 public:
-    //automatic device_id
-    static int next_device_id;
+    //automatic device_id: atomic, so devices can be created from several threads at once
+    static std::atomic<int> next_device_id;
 
     //constructors
     //1- using contructor initializer list (using braces) : here for non-static const/reference data members
-    Device():m_id{next_device_id++},m_type{GPIO},m_status{STARTING},m_buffer_capacity{DEFAULT_BUFFER_CAPACITY},
-             m_buffer{new BYTE[m_buffer_capacity]}{}
+    //every constructor takes an optional std::pmr::memory_resource for the device buffer,
+    //the default resource keeps the plain new/delete behaviour
+    //buffers are limited to 4 GiB (std::length_error beyond)
+    explicit Device(std::pmr::memory_resource* t_resource=std::pmr::get_default_resource())
+        :m_resource{t_resource},m_id{next_device_id++},m_status{packStatus(STARTING,0)},
+         m_buffer_capacity{checkedCapacity(DEFAULT_BUFFER_CAPACITY)},m_type{GPIO}{m_ring=allocateBuffer(m_buffer_capacity);}
 
     //8-Using explicit identifier to prevent expressions such as: Device a =1; see main.cpp
-    explicit Device(DATA_SIZE t_buffer_size):m_id{next_device_id++},m_type{GPIO},m_status{STARTING},m_buffer_capacity{t_buffer_size},
-             m_buffer{new BYTE[t_buffer_size]}{}
+    explicit Device(DATA_SIZE t_buffer_size,std::pmr::memory_resource* t_resource=std::pmr::get_default_resource())
+        :m_resource{t_resource},m_id{next_device_id++},m_status{packStatus(STARTING,0)},
+         m_buffer_capacity{checkedCapacity(t_buffer_size)},m_type{GPIO}{m_ring=allocateBuffer(m_buffer_capacity);}
+
+    Device(DEVICE_TYPE t_type,DEVICE_STATUS t_status,DATA_SIZE t_buffer_size,
+           std::pmr::memory_resource* t_resource=std::pmr::get_default_resource())
+        :m_resource{t_resource},m_id{next_device_id++},m_status{packStatus(t_status,0)},
+         m_buffer_capacity{checkedCapacity(t_buffer_size)},m_type{static_cast<std::uint8_t>(t_type)}{m_ring=allocateBuffer(m_buffer_capacity);}
 
-    Device(DEVICE_TYPE t_type,DEVICE_STATUS t_status,DATA_SIZE t_buffer_size):m_id{next_device_id++},m_type{t_type},
-                                                      m_status{t_status},m_buffer_capacity{t_buffer_size},
-                                                      m_buffer{new BYTE[t_buffer_size]}{}
-    Device(int t_id, DEVICE_TYPE t_type, DEVICE_STATUS t_status,DATA_SIZE t_buffer_size):m_id{t_id},m_type{t_type},m_status{t_status}
-                                                                 ,m_buffer_capacity{t_buffer_size}
-                                                                 ,m_buffer{new BYTE[t_buffer_size]}{}
+    Device(int t_id, DEVICE_TYPE t_type, DEVICE_STATUS t_status,DATA_SIZE t_buffer_size,
+           std::pmr::memory_resource* t_resource=std::pmr::get_default_resource())
+        :m_resource{t_resource},m_id{t_id},m_status{packStatus(t_status,0)},
+         m_buffer_capacity{checkedCapacity(t_buffer_size)},m_type{static_cast<std::uint8_t>(t_type)}{m_ring=allocateBuffer(m_buffer_capacity);}
 
     //also we could define t_source_dev as (const Device&) to serve
     //2- RValue Reference in copy constructor(needed by make_unique function)
-    Device(Device&& t_source_dev):m_id{t_source_dev.m_id},m_type{t_source_dev.m_type},m_status{t_source_dev.m_status}{
-        std::cout<<"#New Device Instance Created using Move Constructor."<<std::endl;
+    //like std::pmr containers, a moved-to device keeps using the memory resource of its source
+    Device(Device&& t_source_dev):m_resource{t_source_dev.m_resource},m_id{t_source_dev.m_id},
+                                 m_status{t_source_dev.m_status.load(std::memory_order_relaxed)},m_type{t_source_dev.m_type}{
+        LIFECYCLE_TRACE(this,"#New Device Instance Created using Move Constructor.");
         *this = std::move(t_source_dev);
     }
 
-    Device(Device& t_source_dev):m_id{t_source_dev.m_id},m_type{t_source_dev.m_type},m_status{t_source_dev.m_status}
-                                ,m_buffer_capacity{t_source_dev.m_buffer_capacity}
-                                ,m_buffer{new BYTE[t_source_dev.m_buffer_capacity]}
+    //like std::pmr containers, a copy does not inherit the source resource: it uses the default resource
+    //the copy gets an empty buffer of the same capacity and an empty event log
+    Device(Device& t_source_dev):m_resource{std::pmr::get_default_resource()},m_id{t_source_dev.m_id}
+                                ,m_status{t_source_dev.m_status.load(std::memory_order_relaxed)}
+                                ,m_buffer_capacity{t_source_dev.m_buffer_capacity},m_type{t_source_dev.m_type}
     {
-        std::cout<<"#New Device Instance Created using Copy Constructor."<<std::endl;
+        m_ring = allocateBuffer(m_buffer_capacity);
+        LIFECYCLE_TRACE(this,"#New Device Instance Created using Copy Constructor.");
     }
 
+    ~Device();
+
+    //throws std::logic_error if either device is owned by a DeviceRegistry (its index would go stale):
+    //erase the device and emplace a new one instead
     Device& operator=(Device&& t_source);
 
-    void addCommentToDevice(std::string t_comment);
-    std::string getComment() const;
+    //comments are kept as a bounded log of (timestamp, interned message) events: memory per device stays constant
+    //the log is cold data, created in the DeviceColdStore by the first comment
+    void addCommentToDevice(std::string_view t_comment);
+    //copy of the recorded events (oldest first), taken under the cold store lock
+    DeviceEventLog getEvents() const;
     DEVICE_STATUS getStatusCode() const;
+    //number of transitions the device went through
+    std::uint32_t getStatusVersion() const;
+    //Lock-free status change (compare-and-swap), safe from any number of threads.
+    //Allowed: STARTING->READY, READY<->IDLE, any running status->FAULT or STOPPED, FAULT/STOPPED->STARTING.
+    //Returns false if the move from the current status is not allowed; moving to the current status is a
+    //no-op that succeeds without a change. t_change (optional) receives the transition that was made.
+    //A device owned by a DeviceRegistry changes status through DeviceRegistry::setStatus, so its query index
+    //follows: transitionTo throws std::logic_error for it.
+    bool transitionTo(DEVICE_STATUS t_status,StatusChange* t_change=nullptr);
+    static bool isAllowedTransition(DEVICE_STATUS t_from,DEVICE_STATUS t_to);
+    DEVICE_TYPE getTypeCode() const;
     int getId() const;
-    const std::string getStatusLabel() const;
-    const std::string getTypeLabel() const;
+    //labels are returned by reference to the shared label tables: no string copy per call
+    const std::string& getStatusLabel() const;
+    const std::string& getTypeLabel() const;
+    static const std::string& statusLabel(DEVICE_STATUS t_status);
+    static const std::string& typeLabel(DEVICE_TYPE t_type);
+    std::pmr::memory_resource* getMemoryResource() const;
+
+    //Device buffer I/O: the buffer is used as a lock-free single-producer/single-consumer ring buffer.
+    //One thread may call write/write_n while another thread calls read/read_n, without any lock.
+    //Moving or assigning a device while it is being read or written is not thread-safe.
+    bool write(BYTE t_byte);
+    bool read(BYTE& t_byte);
+    //bulk versions: copy as many bytes as possible (up to t_count) and publish them with a single index update
+    DATA_SIZE write_n(const BYTE* t_data,DATA_SIZE t_count);
+    DATA_SIZE read_n(BYTE* t_data,DATA_SIZE t_count);
+    //consumer side: copies up to t_count buffered bytes, oldest first, without consuming them
+    DATA_SIZE peek_n(BYTE* t_data,DATA_SIZE t_count) const;
+    //bytes currently buffered (a snapshot when producer/consumer are running)
+    DATA_SIZE getDataSize() const;
+    DATA_SIZE getBufferCapacity() const;
+
+    //Idle buffer compression (opt-in, see BufferCompressor): the buffered bytes are compressed with LzCodec into
+    //a block just big enough for them, and the ring buffer goes back to the memory resource. The next
+    //write/read (from either side, safely) decompresses it; getDataSize and peek_n read the compressed bytes.
+    //compressBuffer is safe while other threads use the device: it returns false if the buffer is being
+    //read or written at the time, or if there is nothing to compress (no buffer, or already compressed).
+    bool compressBuffer();
+    bool isBufferCompressed() const;
+    static BufferCompressionStats compressionStats();
+
+    //bytes (and alignment) one buffer of t_capacity takes from the memory resource, ring header included
+    static std::size_t bufferAllocationSize(DATA_SIZE t_capacity);
+    static const std::size_t BUFFER_ALIGNMENT = CACHE_LINE_SIZE;
 
 private:
+    friend class DeviceRegistry;        //marks its devices and changes their status with applyTransition
+
+    //ring buffer indexes, in front of the buffer bytes. They only grow, position in the buffer is
+    //index % capacity. The producer and the consumer side each get their own cache line.
+    struct RingHeader{
+        //producer side: written by write/write_n, plus its cached copy of the consumer index
+        alignas(CACHE_LINE_SIZE) std::atomic<DATA_SIZE> write_index{0};
+        DATA_SIZE cached_read_index=0;
+        //consumer side: written by read/read_n, plus its cached copy of the producer index
+        alignas(CACHE_LINE_SIZE) std::atomic<DATA_SIZE> read_index{0};
+        DATA_SIZE cached_write_index=0;
+
+        BYTE* data(){return reinterpret_cast<BYTE*>(this+1);}
+        const BYTE* data() const {return reinterpret_cast<const BYTE*>(this+1);}
+    };
+
+    //a compressed buffer: its sizes, then the LzCodec block (or the plain bytes when they did not compress)
+    struct PackedBuffer;
+    //m_buffer_state, low bits: which member of the buffer union is live. BUFFER_BUSY: one thread is
+    //compressing, reading or decompressing the packed buffer, the others wait.
+    //Upper bits: number of ring accesses in progress (BUFFER_ACCESS each), a compression waits for none.
+    enum BUFFER_STATE : std::uint8_t{BUFFER_PLAIN,BUFFER_PACKED,BUFFER_BUSY,BUFFER_STATE_MASK=3,BUFFER_ACCESS=4};
+
+    //status word: the status in the low byte, the status version above it
+    static std::uint32_t packStatus(DEVICE_STATUS t_status,std::uint32_t t_version) {return t_version<<8 | static_cast<std::uint32_t>(t_status);}
+    static std::uint32_t checkedCapacity(DATA_SIZE t_capacity);
+    //the compare-and-swap loop of transitionTo, without the ownership check
+    bool applyTransition(DEVICE_STATUS t_status,StatusChange* t_change);
+    //nullptr for a zero capacity
+    RingHeader* allocateBuffer(DATA_SIZE t_size);
+    void releaseBuffer();
+    void releaseColdData();
+    //ring access: enterRing returns false if the buffer is not plain, otherwise the ring stays plain
+    //(cannot be compressed) until leaveRing. At most 63 accesses at a time (the producer, the consumer
+    //and peekers).
+    bool enterRing() const;
+    void leaveRing() const;
+    //the ring buffer I/O itself, ring held
+    DATA_SIZE writeRing(const BYTE* t_data,DATA_SIZE t_count);
+    DATA_SIZE readRing(BYTE* t_data,DATA_SIZE t_count);
+    DATA_SIZE peekRing(BYTE* t_data,DATA_SIZE t_count) const;
+    DATA_SIZE ringDataSize() const;
+    //packed buffer access: lockPacked returns false if the buffer is plain, otherwise it holds BUFFER_BUSY
+    //until unlockPacked
+    bool lockPacked() const;
+    void unlockPacked() const;
+    //makes the buffer plain again (write/read side, before touching the ring)
+    void unpackBuffer();
+    //memory the packed buffer gives back, compared with the ring buffer
+    std::size_t packedSavings() const;
+
+    //hot fields, widest first so the record packs without holes
+    union{
+        RingHeader* m_ring=nullptr;     //BUFFER_PLAIN
+        PackedBuffer* m_packed;         //BUFFER_PACKED, nullptr when no byte was buffered
+    };
+    std::pmr::memory_resource* m_resource;
     const int m_id;
-    DEVICE_TYPE m_type;
-    DEVICE_STATUS m_status;
-    std::string m_comment;
-    DATA_SIZE m_buffer_capacity=DEFAULT_BUFFER_CAPACITY;
-    int m_buffer_data_size;
-    BYTE* m_buffer=new BYTE[m_buffer_capacity];
+    std::atomic<std::uint32_t> m_status;
+    std::uint32_t m_buffer_capacity=0;
+    std::uint8_t m_type;
+    bool m_has_cold_data=false;     //this object has an entry in the DeviceColdStore
+    bool m_registry_owned=false;    //set by DeviceRegistry, which indexes the type and status
+    mutable std::atomic<std::uint8_t> m_buffer_state{BUFFER_PLAIN};
 };
 
+static_assert(sizeof(Device)<=32,"Device is the hot record scanned by registries: keep it within half a cache line");
+
+//smart std::unique_pointer usage
+std::unique_ptr<Device> createDevice(DEVICE_TYPE t_type,DEVICE_STATUS t_status);
+
 #endif // DEVICE_H
@@ -0,0 +1,184 @@
+#include "device_bitmap_index.h"
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DEVICE_BITMAP_X86 1
+#endif
+
+typedef DeviceBitmap::WORD WORD;
+
+namespace{
+
+//the bitmaps a query combines: (OR of types) AND (OR of statuses, when any)
+struct QueryWords{
+    const WORD* types[DEVICE_TYPE_COUNT];
+    const WORD* statuses[DEVICE_STATUS_COUNT];
+    std::size_t type_count=0;
+    std::size_t status_count=0;
+};
+
+std::size_t evaluateScalar(const QueryWords& t_query,std::size_t t_begin,std::size_t t_end,WORD* t_out)
+{
+    std::size_t total = 0;
+    for(std::size_t w=t_begin;w<t_end;++w)
+    {
+        WORD result = t_query.types[0][w];
+        for(std::size_t i=1;i<t_query.type_count;++i)
+            result |= t_query.types[i][w];
+        if(t_query.status_count)
+        {
+            WORD status = t_query.statuses[0][w];
+            for(std::size_t i=1;i<t_query.status_count;++i)
+                status |= t_query.statuses[i][w];
+            result &= status;
+        }
+        if(t_out)
+            t_out[w] = result;
+        total += static_cast<std::size_t>(__builtin_popcountll(result));
+    }
+    return total;
+}
+
+#if defined(DEVICE_BITMAP_X86)
+//256 bits at a time, compiled for AVX2 whatever the build flags and only called when the CPU has it
+__attribute__((target("avx2"))) std::size_t evaluateAvx2(const QueryWords& t_query,std::size_t t_word_count,WORD* t_out)
+{
+    std::size_t total = 0;
+    std::size_t w = 0;
+    for(;w+4<=t_word_count;w+=4)
+    {
+        __m256i result = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_query.types[0]+w));
+        for(std::size_t i=1;i<t_query.type_count;++i)
+            result = _mm256_or_si256(result,_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_query.types[i]+w)));
+        if(t_query.status_count)
+        {
+            __m256i status = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_query.statuses[0]+w));
+            for(std::size_t i=1;i<t_query.status_count;++i)
+                status = _mm256_or_si256(status,_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_query.statuses[i]+w)));
+            result = _mm256_and_si256(result,status);
+        }
+        alignas(32) WORD lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes),result);
+        if(t_out)
+            std::copy(lanes,lanes+4,t_out+w);
+        total += __builtin_popcountll(lanes[0])+__builtin_popcountll(lanes[1])
+                +__builtin_popcountll(lanes[2])+__builtin_popcountll(lanes[3]);
+    }
+    return total+evaluateScalar(t_query,w,t_word_count,t_out);
+}
+
+bool cpuHasAvx2()
+{
+    static const bool avx2 = (__builtin_cpu_init(),__builtin_cpu_supports("avx2"));
+    return avx2;
+}
+#endif
+
+}
+
+void DeviceBitmap::resize(std::size_t t_bits)
+{
+    if(t_bits<=m_bit_count)
+        return;
+    m_words.resize((t_bits+WORD_BITS-1)/WORD_BITS,0);
+    m_bit_count = t_bits;
+}
+
+void DeviceBitmap::clear()
+{
+    std::fill(m_words.begin(),m_words.end(),0);
+}
+
+std::size_t DeviceBitmap::count() const
+{
+    std::size_t total = 0;
+    for(WORD word:m_words)
+        total += static_cast<std::size_t>(__builtin_popcountll(word));
+    return total;
+}
+
+//grows every bitmap geometrically, so adding devices one by one stays amortized O(1)
+void DeviceBitmapIndex::reserveSlot(std::size_t t_slot)
+{
+    if(t_slot<m_slot_capacity)
+        return;
+    m_slot_capacity = std::max<std::size_t>(t_slot+1,m_slot_capacity*2);
+    for(auto& bitmap:m_types)
+        bitmap.resize(m_slot_capacity);
+    for(auto& bitmap:m_statuses)
+        bitmap.resize(m_slot_capacity);
+}
+
+void DeviceBitmapIndex::add(std::size_t t_slot,DEVICE_TYPE t_type,DEVICE_STATUS t_status)
+{
+    reserveSlot(t_slot);
+    m_types[t_type].set(t_slot);
+    m_statuses[t_status].set(t_slot);
+}
+
+void DeviceBitmapIndex::remove(std::size_t t_slot,DEVICE_TYPE t_type,DEVICE_STATUS t_status)
+{
+    if(t_slot>=m_slot_capacity)
+        return;
+    m_types[t_type].reset(t_slot);
+    m_statuses[t_status].reset(t_slot);
+}
+
+void DeviceBitmapIndex::updateStatus(std::size_t t_slot,DEVICE_STATUS t_old_status,DEVICE_STATUS t_new_status)
+{
+    if(t_slot>=m_slot_capacity)
+        return;
+    m_statuses[t_old_status].reset(t_slot);
+    m_statuses[t_new_status].set(t_slot);
+}
+
+void DeviceBitmapIndex::clear()
+{
+    for(auto& bitmap:m_types)
+        bitmap.clear();
+    for(auto& bitmap:m_statuses)
+        bitmap.clear();
+}
+
+//(OR of the selected type bitmaps) AND (OR of the selected status bitmaps), one pass over the words.
+//An empty dimension selects every type: each indexed slot has exactly one type, so their union is "all devices".
+//The AVX2 version is picked at runtime (same dispatch as the DataBuffer byte kernels).
+std::size_t DeviceBitmapIndex::evaluate(const DeviceQuery& t_query,WORD* t_out) const
+{
+    QueryWords query;
+    const unsigned type_mask = t_query.typeMask() ? t_query.typeMask() : (1u<<DEVICE_TYPE_COUNT)-1;
+    for(int t=0;t<DEVICE_TYPE_COUNT;++t)
+        if(type_mask & (1u<<t))
+            query.types[query.type_count++] = m_types[t].words();
+    for(int s=0;s<DEVICE_STATUS_COUNT;++s)
+        if(t_query.statusMask() & (1u<<s))
+            query.statuses[query.status_count++] = m_statuses[s].words();
+
+    const std::size_t word_count = m_types[0].wordCount();
+#if defined(DEVICE_BITMAP_X86)
+    if(cpuHasAvx2())
+        return evaluateAvx2(query,word_count,t_out);
+#endif
+    return evaluateScalar(query,0,word_count,t_out);
+}
+
+std::size_t DeviceBitmapIndex::count(const DeviceQuery& t_query) const
+{
+    return evaluate(t_query,nullptr);
+}
+
+DeviceBitmap DeviceBitmapIndex::select(const DeviceQuery& t_query) const
+{
+    DeviceBitmap result;
+    result.resize(m_slot_capacity);
+    evaluate(t_query,result.words());
+    return result;
+}
+
+std::array<std::size_t,DEVICE_TYPE_COUNT> DeviceBitmapIndex::countByType(DEVICE_STATUS t_status) const
+{
+    std::array<std::size_t,DEVICE_TYPE_COUNT> counts{};
+    for(int t=0;t<DEVICE_TYPE_COUNT;++t)
+        counts[t] = count(DeviceQuery().type(static_cast<DEVICE_TYPE>(t)).status(t_status));
+    return counts;
+}
@@ -0,0 +1,93 @@
+#ifndef DEVICE_BITMAP_INDEX_H
+#define DEVICE_BITMAP_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "device.h"
+
+//Plain growable bitmap, one bit per device slot, stored in 64-bit words
+class DeviceBitmap{
+public:
+    typedef std::uint64_t WORD;
+    static const std::size_t WORD_BITS = 64;
+
+    std::size_t bitCount() const {return m_bit_count;}
+    std::size_t wordCount() const {return m_words.size();}
+    const WORD* words() const {return m_words.data();}
+    WORD* words(){return m_words.data();}
+
+    //grows (never shrinks) to hold at least t_bits bits, new bits are cleared
+    void resize(std::size_t t_bits);
+    void clear();
+
+    void set(std::size_t t_bit){m_words[t_bit/WORD_BITS] |= WORD(1)<<(t_bit%WORD_BITS);}
+    void reset(std::size_t t_bit){m_words[t_bit/WORD_BITS] &= ~(WORD(1)<<(t_bit%WORD_BITS));}
+    bool test(std::size_t t_bit) const
+    {
+        return t_bit<m_bit_count && (m_words[t_bit/WORD_BITS]>>(t_bit%WORD_BITS)) & 1u;
+    }
+
+    //popcount of the whole bitmap
+    std::size_t count() const;
+
+    //calls t_visitor(bit) for every set bit, in increasing order
+    template<typename Visitor>
+    void forEachSet(Visitor&& t_visitor) const
+    {
+        for(std::size_t w=0;w<m_words.size();++w)
+            for(WORD word=m_words[w];word!=0;word&=word-1)
+                t_visitor(w*WORD_BITS+static_cast<std::size_t>(__builtin_ctzll(word)));
+    }
+
+private:
+    std::vector<WORD> m_words;
+    std::size_t m_bit_count=0;
+};
+
+//Compound filter: a device matches if its type is one of the selected types AND its status one of the selected statuses.
+//Nothing selected in a dimension means any value, e.g. DeviceQuery().type(PRINTER).status(FAULT) or DeviceQuery().status(IDLE)
+class DeviceQuery{
+public:
+    DeviceQuery& type(DEVICE_TYPE t_type){m_type_mask |= 1u<<t_type; return *this;}
+    DeviceQuery& status(DEVICE_STATUS t_status){m_status_mask |= 1u<<t_status; return *this;}
+
+    unsigned typeMask() const {return m_type_mask;}
+    unsigned statusMask() const {return m_status_mask;}
+
+private:
+    unsigned m_type_mask=0;
+    unsigned m_status_mask=0;
+};
+
+//Secondary index over device slots: one bitmap per DEVICE_TYPE and one per DEVICE_STATUS, updated on every
+//insertion, removal and status change. Queries OR the selected bitmaps of each dimension and AND the two
+//results word by word (256 bits at a time on CPUs with AVX2), counts use popcount: no Device object is touched.
+class DeviceBitmapIndex{
+public:
+    void add(std::size_t t_slot,DEVICE_TYPE t_type,DEVICE_STATUS t_status);
+    void remove(std::size_t t_slot,DEVICE_TYPE t_type,DEVICE_STATUS t_status);
+    void updateStatus(std::size_t t_slot,DEVICE_STATUS t_old_status,DEVICE_STATUS t_new_status);
+    void clear();
+
+    //number of indexed devices matching the query, without building a result bitmap
+    std::size_t count(const DeviceQuery& t_query) const;
+    //bitmap of the matching slots
+    DeviceBitmap select(const DeviceQuery& t_query) const;
+    //e.g. "how many devices are IDLE per type"
+    std::array<std::size_t,DEVICE_TYPE_COUNT> countByType(DEVICE_STATUS t_status) const;
+
+    const DeviceBitmap& typeBitmap(DEVICE_TYPE t_type) const {return m_types[t_type];}
+    const DeviceBitmap& statusBitmap(DEVICE_STATUS t_status) const {return m_statuses[t_status];}
+
+private:
+    void reserveSlot(std::size_t t_slot);
+    std::size_t evaluate(const DeviceQuery& t_query,DeviceBitmap::WORD* t_out) const;
+
+    std::array<DeviceBitmap,DEVICE_TYPE_COUNT> m_types;
+    std::array<DeviceBitmap,DEVICE_STATUS_COUNT> m_statuses;
+    std::size_t m_slot_capacity=0;
+};
+
+#endif // DEVICE_BITMAP_INDEX_H
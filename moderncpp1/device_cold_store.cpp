@@ -0,0 +1,46 @@
+#include "device_cold_store.h"
+
+DeviceColdStore& DeviceColdStore::global()
+{
+    //never destroyed: devices with static storage may release their entry after main returns
+    static DeviceColdStore* store = new DeviceColdStore;
+    return *store;
+}
+
+void DeviceColdStore::record(const Device* t_owner,std::string_view t_message)
+{
+    //interned before taking the store lock
+    const StringInterner::Id message_id = StringInterner::global().intern(t_message);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_logs[t_owner].record(message_id);
+}
+
+void DeviceColdStore::move(const Device* t_from,const Device* t_to)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_logs.erase(t_to);
+    auto node = m_logs.extract(t_from);
+    if(node.empty())
+        return;
+    node.key() = t_to;
+    m_logs.insert(std::move(node));
+}
+
+void DeviceColdStore::erase(const Device* t_owner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_logs.erase(t_owner);
+}
+
+DeviceEventLog DeviceColdStore::events(const Device* t_owner) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_logs.find(t_owner);
+    return it!=m_logs.end() ? it->second : DeviceEventLog();
+}
+
+std::size_t DeviceColdStore::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_logs.size();
+}
@@ -0,0 +1,36 @@
+#ifndef DEVICE_COLD_STORE_H
+#define DEVICE_COLD_STORE_H
+
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include "device_event_log.h"
+
+class Device;
+
+//Cold part of the devices: data that status scans never read (today the event log), kept out of the
+//Device object in a table keyed by the owning Device object. Not keyed by device id: a copy has the id of
+//its source, so ids do not name one log. A device only gets an entry once it records an event; a move
+//hands the entry over to the target object, a copy starts without one.
+//Thread-safe: every call takes the store lock, and logs are only read as copies taken under it.
+class DeviceColdStore{
+public:
+    static DeviceColdStore& global();
+
+    //records into the log of t_owner, creating it if needed
+    void record(const Device* t_owner,std::string_view t_message);
+    //the log of t_from becomes the log of t_to (whose previous log is dropped)
+    void move(const Device* t_from,const Device* t_to);
+    void erase(const Device* t_owner);
+
+    //copy of the log of t_owner, empty if it has none
+    DeviceEventLog events(const Device* t_owner) const;
+    std::size_t size() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<const Device*,DeviceEventLog> m_logs;
+};
+
+#endif // DEVICE_COLD_STORE_H
@@ -0,0 +1,86 @@
+#ifndef DEVICE_EVENT_LOG_H
+#define DEVICE_EVENT_LOG_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include "string_interner.h"
+
+//One entry of a device event log: when it happened and what (as an interned message)
+struct DeviceEvent{
+    std::uint64_t timestamp_ns;         //std::chrono::steady_clock time since its epoch
+    StringInterner::Id message_id;
+
+    std::chrono::steady_clock::time_point time() const
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timestamp_ns));
+    }
+    std::string_view message() const {return StringInterner::global().lookup(message_id);}
+};
+
+//Fixed-capacity ring of the most recent events: once full, a new event overwrites the oldest one,
+//so the memory used by a log never depends on how long the device has been running.
+template<std::size_t CAPACITY>
+class EventRing{
+public:
+    static_assert(CAPACITY>0,"EventRing needs room for at least one event");
+
+    void record(std::string_view t_message)
+    {
+        record(StringInterner::global().intern(t_message));
+    }
+
+    void record(StringInterner::Id t_message_id)
+    {
+        const std::uint64_t now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        m_events[(m_first+m_size)%CAPACITY] = DeviceEvent{now,t_message_id};
+        if(m_size<CAPACITY)
+            ++m_size;
+        else
+            m_first = (m_first+1)%CAPACITY;
+    }
+
+    void clear(){m_first=0;m_size=0;}
+    std::size_t size() const {return m_size;}
+    bool empty() const {return m_size==0;}
+    static constexpr std::size_t capacity(){return CAPACITY;}
+
+    //iterates from the oldest to the newest event
+    class const_iterator{
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = DeviceEvent;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const DeviceEvent*;
+        using reference = const DeviceEvent&;
+
+        const_iterator(const EventRing* t_ring,std::size_t t_position):m_ring{t_ring},m_position{t_position}{}
+        reference operator*() const {return m_ring->m_events[(m_ring->m_first+m_position)%CAPACITY];}
+        pointer operator->() const {return &**this;}
+        const_iterator& operator++(){++m_position;return *this;}
+        const_iterator operator++(int){const_iterator tmp=*this;++m_position;return tmp;}
+        bool operator==(const const_iterator& t_other) const {return m_position==t_other.m_position;}
+        bool operator!=(const const_iterator& t_other) const {return m_position!=t_other.m_position;}
+    private:
+        const EventRing* m_ring;
+        std::size_t m_position;
+    };
+
+    const_iterator begin() const {return const_iterator(this,0);}
+    const_iterator end() const {return const_iterator(this,m_size);}
+
+private:
+    std::array<DeviceEvent,CAPACITY> m_events{};
+    std::uint32_t m_first=0;
+    std::uint32_t m_size=0;
+};
+
+//number of events each device keeps
+const std::size_t DEVICE_EVENT_LOG_CAPACITY = 8;
+typedef EventRing<DEVICE_EVENT_LOG_CAPACITY> DeviceEventLog;
+
+#endif // DEVICE_EVENT_LOG_H
@@ -0,0 +1,68 @@
+#include "device_registry.h"
+
+DeviceRegistry::DeviceRegistry(std::size_t t_expected_devices)
+{
+    m_id_index.reserve(t_expected_devices);
+}
+
+Device* DeviceRegistry::find(DeviceHandle t_handle)
+{
+    return m_devices.get(t_handle);
+}
+
+const Device* DeviceRegistry::find(DeviceHandle t_handle) const
+{
+    return m_devices.get(t_handle);
+}
+
+Device* DeviceRegistry::findById(int t_id)
+{
+    return m_devices.get(handleOf(t_id));
+}
+
+const Device* DeviceRegistry::findById(int t_id) const
+{
+    return m_devices.get(handleOf(t_id));
+}
+
+DeviceHandle DeviceRegistry::handleOf(int t_id) const
+{
+    auto it = m_id_index.find(t_id);
+    return it==m_id_index.end() ? DeviceHandle{} : it->second;
+}
+
+bool DeviceRegistry::erase(DeviceHandle t_handle)
+{
+    const Device* device = m_devices.get(t_handle);
+    if(device==nullptr)
+        return false;
+    m_id_index.erase(device->getId());
+    m_query_index.remove(t_handle.index,device->getTypeCode(),device->getStatusCode());
+    return m_devices.erase(t_handle);
+}
+
+bool DeviceRegistry::setStatus(DeviceHandle t_handle,DEVICE_STATUS t_status)
+{
+    Device* device = m_devices.get(t_handle);
+    if(device==nullptr)
+        return false;
+    StatusChange change;
+    if(!device->applyTransition(t_status,&change))
+        return false;
+    m_query_index.updateStatus(t_handle.index,change.from,change.to);
+    if(m_notifier)
+        m_notifier->publish(change);
+    return true;
+}
+
+bool DeviceRegistry::eraseById(int t_id)
+{
+    return erase(handleOf(t_id));
+}
+
+void DeviceRegistry::clear()
+{
+    m_devices.clear();
+    m_id_index.clear();
+    m_query_index.clear();
+}
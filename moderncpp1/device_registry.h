@@ -0,0 +1,100 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include "device.h"
+#include "device_bitmap_index.h"
+#include "slot_map.h"
+#include "status_notifier.h"
+#include "work_stealing_pool.h"
+
+typedef SlotMap<Device>::Handle DeviceHandle;
+
+//Owns devices by value inside a slot map (no per-device heap node, no pointer chasing on scans)
+//and keeps an id -> handle hash index for O(1) lookup by Device::getId().
+//Handles stay valid across insertions and are invalidated only by erasing that device.
+//A bitmap index over slots answers type/status queries without visiting the devices. It cannot go stale:
+//registered devices change status only through setStatus and refuse move assignment (std::logic_error).
+class DeviceRegistry{
+public:
+    DeviceRegistry()=default;
+    explicit DeviceRegistry(std::size_t t_expected_devices);
+
+    //constructs the device in place using any Device constructor
+    //throws std::invalid_argument if a device with the same id is already registered
+    template<typename... Args>
+    DeviceHandle emplace(Args&&... t_args)
+    {
+        DeviceHandle handle = m_devices.emplace(std::forward<Args>(t_args)...);
+        const int id = m_devices.get(handle)->getId();
+        if(!m_id_index.emplace(id,handle).second)
+        {
+            m_devices.erase(handle);
+            throw std::invalid_argument("DeviceRegistry: duplicate device id "+std::to_string(id));
+        }
+        Device* device = m_devices.get(handle);
+        device->m_registry_owned = true;
+        m_query_index.add(handle.index,device->getTypeCode(),device->getStatusCode());
+        return handle;
+    }
+
+    Device* find(DeviceHandle t_handle);
+    const Device* find(DeviceHandle t_handle) const;
+    Device* findById(int t_id);
+    const Device* findById(int t_id) const;
+    //returns an invalid handle (DeviceHandle{}) if the id is unknown
+    DeviceHandle handleOf(int t_id) const;
+
+    //changes the device status (see Device::transitionTo) and keeps the query index in sync,
+    //returns false for a stale handle or a transition that is not allowed
+    bool setStatus(DeviceHandle t_handle,DEVICE_STATUS t_status);
+    //every status change made through setStatus is published to t_notifier (nullptr: none)
+    void setStatusNotifier(StatusNotifier* t_notifier) {m_notifier = t_notifier;}
+
+    //bitmap queries, e.g. count(DeviceQuery().type(PRINTER).status(FAULT))
+    std::size_t count(const DeviceQuery& t_query) const {return m_query_index.count(t_query);}
+    std::array<std::size_t,DEVICE_TYPE_COUNT> countByType(DEVICE_STATUS t_status) const {return m_query_index.countByType(t_status);}
+    //calls t_visitor(Device&) for every matching device, in slot order
+    template<typename Visitor>
+    void forEachMatch(const DeviceQuery& t_query,Visitor&& t_visitor)
+    {
+        m_query_index.select(t_query).forEachSet([&](std::size_t t_slot){
+            t_visitor(*m_devices.get(m_devices.handleAt(t_slot)));
+        });
+    }
+
+    //calls t_visitor(Device&) for every device from the threads of t_pool (WorkStealingPool::parallelFor
+    //over the slots, t_chunk slots at a time): the visitor must be safe to run on different devices at once
+    template<typename Visitor>
+    void parallelForEach(WorkStealingPool& t_pool,Visitor&& t_visitor,std::size_t t_chunk=0)
+    {
+        t_pool.parallelFor(m_devices.slotCount(),t_chunk,[&](std::size_t t_slot){
+            if(Device* device = m_devices.get(m_devices.handleAt(t_slot)))
+                t_visitor(*device);
+        });
+    }
+
+    bool erase(DeviceHandle t_handle);
+    bool eraseById(int t_id);
+    void clear();
+
+    std::size_t size() const {return m_devices.size();}
+    bool empty() const {return m_devices.empty();}
+
+    //range-based for loop support: iterates devices in slot order
+    SlotMap<Device>::iterator begin(){return m_devices.begin();}
+    SlotMap<Device>::iterator end(){return m_devices.end();}
+    SlotMap<Device>::const_iterator begin() const {return m_devices.begin();}
+    SlotMap<Device>::const_iterator end() const {return m_devices.end();}
+
+private:
+    SlotMap<Device> m_devices;
+    std::unordered_map<int,DeviceHandle> m_id_index;
+    DeviceBitmapIndex m_query_index;
+    StatusNotifier* m_notifier=nullptr;
+};
+
+#endif // DEVICE_REGISTRY_H
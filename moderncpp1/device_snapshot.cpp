@@ -0,0 +1,305 @@
+#include "device_snapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace{
+
+struct SnapshotHeader{
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t flags;
+    std::uint32_t record_size;
+    std::uint32_t check;            //of the header with this field set to 0
+    std::uint64_t record_count;
+    std::int64_t next_device_id;
+    std::uint64_t records_offset;
+    std::uint64_t data_offset;
+    std::uint64_t data_size;
+    std::uint8_t reserved[8];
+};
+static_assert(sizeof(SnapshotHeader)==64,"the header layout is part of the file format");
+
+const char SNAPSHOT_MAGIC[4]={'D','S','N','P'};
+const std::uint64_t SECTION_ALIGNMENT = 64;
+
+//FNV-1a: cheap enough to check a record on every access
+std::uint32_t fnv1a(const void* t_data,std::size_t t_size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(t_data);
+    std::uint32_t hash = 2166136261u;
+    for(std::size_t i=0;i<t_size;++i)
+        hash = (hash^bytes[i])*16777619u;
+    return hash;
+}
+
+std::uint32_t headerCheck(SnapshotHeader t_header)
+{
+    t_header.check = 0;
+    return fnv1a(&t_header,sizeof(t_header));
+}
+
+std::uint64_t alignUp(std::uint64_t t_value)
+{
+    return (t_value+SECTION_ALIGNMENT-1)/SECTION_ALIGNMENT*SECTION_ALIGNMENT;
+}
+
+//writes at an absolute offset, retrying short writes
+void writeAt(int t_fd,const void* t_data,std::size_t t_size,std::uint64_t t_offset)
+{
+    const char* data = static_cast<const char*>(t_data);
+    while(t_size)
+    {
+        ssize_t written = ::pwrite(t_fd,data,t_size,static_cast<off_t>(t_offset));
+        if(written<0)
+        {
+            if(errno==EINTR)
+                continue;
+            throw std::system_error(errno,std::generic_category(),"DeviceSnapshot: write");
+        }
+        data += written;
+        t_size -= static_cast<std::size_t>(written);
+        t_offset += static_cast<std::uint64_t>(written);
+    }
+}
+
+}
+
+std::uint32_t DeviceSnapshot::recordCheck(const Record& t_record)
+{
+    return fnv1a(&t_record,offsetof(Record,check));
+}
+
+void DeviceSnapshot::save(const std::string& t_path,const DeviceRegistry& t_registry,bool t_include_buffers)
+{
+    //records sorted by id, so a restart can look devices up with a binary search over the mapping
+    std::vector<const Device*> devices;
+    devices.reserve(t_registry.size());
+    for(const Device& device:t_registry)
+        devices.push_back(&device);
+    std::sort(devices.begin(),devices.end(),[](const Device* t_a,const Device* t_b){return t_a->getId()<t_b->getId();});
+
+    std::vector<Record> records(devices.size());
+    std::uint64_t data_size = 0;
+    DATA_SIZE largest_buffer = 0;
+    for(std::size_t i=0;i<devices.size();++i)
+    {
+        const Device& device = *devices[i];
+        Record& record = records[i];
+        std::memset(&record,0,sizeof(record));
+        record.id = device.getId();
+        record.type = static_cast<std::uint8_t>(device.getTypeCode());
+        record.status = static_cast<std::uint8_t>(device.getStatusCode());
+        record.buffer_capacity = static_cast<std::uint32_t>(device.getBufferCapacity());
+        if(t_include_buffers)
+        {
+            record.data_size = static_cast<std::uint32_t>(device.getDataSize());
+            record.data_offset = data_size;
+            data_size += record.data_size;
+            largest_buffer = std::max(largest_buffer,device.getBufferCapacity());
+        }
+        record.check = recordCheck(record);
+    }
+
+    SnapshotHeader header;
+    std::memset(&header,0,sizeof(header));
+    std::memcpy(header.magic,SNAPSHOT_MAGIC,sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.flags = t_include_buffers ? FLAG_BUFFERS : 0;
+    header.record_size = sizeof(Record);
+    header.record_count = records.size();
+    header.next_device_id = Device::next_device_id.load();
+    header.records_offset = alignUp(sizeof(SnapshotHeader));
+    header.data_offset = alignUp(header.records_offset+records.size()*sizeof(Record));
+    header.data_size = data_size;
+    header.check = headerCheck(header);
+
+    const std::string temporary_path = t_path+".tmp";
+    const int fd = ::open(temporary_path.c_str(),O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,0644);
+    if(fd<0)
+        throw std::system_error(errno,std::generic_category(),"DeviceSnapshot: cannot create "+temporary_path);
+    try
+    {
+        writeAt(fd,&header,sizeof(header),0);
+        writeAt(fd,records.data(),records.size()*sizeof(Record),header.records_offset);
+        if(t_include_buffers)
+        {
+            //one chunk buffer for all the devices: flushed whenever the next device would not fit
+            std::vector<BYTE> chunk(std::max<std::size_t>(largest_buffer,1<<20));
+            std::size_t used = 0;
+            std::uint64_t chunk_offset = header.data_offset;
+            for(std::size_t i=0;i<devices.size();++i)
+            {
+                if(used+records[i].data_size>chunk.size())
+                {
+                    writeAt(fd,chunk.data(),used,chunk_offset);
+                    chunk_offset += used;
+                    used = 0;
+                }
+                used += devices[i]->peek_n(chunk.data()+used,records[i].data_size);
+            }
+            writeAt(fd,chunk.data(),used,chunk_offset);
+        }
+        //the sections are aligned: without buffered bytes nothing is written up to data_offset,
+        //so the file has to be extended to cover the (empty) data section
+        if(::ftruncate(fd,static_cast<off_t>(header.data_offset+header.data_size))<0)
+            throw std::system_error(errno,std::generic_category(),"DeviceSnapshot: ftruncate");
+        if(::fdatasync(fd)<0)
+            throw std::system_error(errno,std::generic_category(),"DeviceSnapshot: fdatasync");
+    }
+    catch(...)
+    {
+        ::close(fd);
+        ::unlink(temporary_path.c_str());
+        throw;
+    }
+    ::close(fd);
+    if(::rename(temporary_path.c_str(),t_path.c_str())<0)
+    {
+        const int error = errno;
+        ::unlink(temporary_path.c_str());
+        throw std::system_error(error,std::generic_category(),"DeviceSnapshot: cannot replace "+t_path);
+    }
+}
+
+DeviceSnapshot::DeviceSnapshot(const std::string& t_path)
+{
+    const int fd = ::open(t_path.c_str(),O_RDONLY|O_CLOEXEC);
+    if(fd<0)
+        throw std::system_error(errno,std::generic_category(),"DeviceSnapshot: cannot open "+t_path);
+    struct stat info;
+    if(::fstat(fd,&info)<0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error,std::generic_category(),"DeviceSnapshot: cannot stat "+t_path);
+    }
+    if(static_cast<std::uint64_t>(info.st_size)<sizeof(SnapshotHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("DeviceSnapshot: "+t_path+" is too small to be a snapshot");
+    }
+    m_mapping_size = static_cast<std::size_t>(info.st_size);
+    void* address = ::mmap(nullptr,m_mapping_size,PROT_READ,MAP_PRIVATE,fd,0);
+    const int error = errno;
+    ::close(fd);        //the mapping keeps the file alive
+    if(address==MAP_FAILED)
+        throw std::system_error(error,std::generic_category(),"DeviceSnapshot: cannot map "+t_path);
+    m_mapping = static_cast<const unsigned char*>(address);
+
+    SnapshotHeader header;
+    std::memcpy(&header,m_mapping,sizeof(header));
+    const char* problem = nullptr;
+    if(std::memcmp(header.magic,SNAPSHOT_MAGIC,sizeof(header.magic))!=0)
+        problem = "not a device snapshot";
+    else if(header.version!=FORMAT_VERSION)
+        problem = "unsupported snapshot version";
+    else if(header.check!=headerCheck(header))
+        problem = "corrupt snapshot header";
+    else if(header.record_size!=sizeof(Record) || header.records_offset%alignof(Record)!=0
+            || header.records_offset>m_mapping_size
+            || header.record_count>(m_mapping_size-header.records_offset)/sizeof(Record)
+            || header.data_offset>m_mapping_size || header.data_size>m_mapping_size-header.data_offset)
+        problem = "snapshot sections do not fit in the file";
+    if(problem)
+    {
+        ::munmap(const_cast<unsigned char*>(m_mapping),m_mapping_size);
+        throw std::runtime_error("DeviceSnapshot: "+t_path+": "+problem);
+    }
+    m_flags = header.flags;
+    m_record_count = static_cast<std::size_t>(header.record_count);
+    m_next_device_id = static_cast<int>(header.next_device_id);
+    m_records_offset = header.records_offset;
+    m_data_offset = header.data_offset;
+    m_data_size = header.data_size;
+}
+
+DeviceSnapshot::~DeviceSnapshot()
+{
+    ::munmap(const_cast<unsigned char*>(m_mapping),m_mapping_size);
+}
+
+void DeviceSnapshot::validate(const Record& t_record,std::size_t t_index) const
+{
+    const bool valid = t_record.check==recordCheck(t_record)
+            && t_record.type<DEVICE_TYPE_COUNT && t_record.status<DEVICE_STATUS_COUNT
+            && t_record.data_size<=t_record.buffer_capacity
+            && (hasBuffers() ? t_record.data_offset<=m_data_size && t_record.data_size<=m_data_size-t_record.data_offset
+                             : t_record.data_size==0);
+    if(!valid)
+        throw std::runtime_error("DeviceSnapshot: corrupt record "+std::to_string(t_index));
+}
+
+const DeviceSnapshot::Record& DeviceSnapshot::record(std::size_t t_index) const
+{
+    if(t_index>=m_record_count)
+        throw std::out_of_range("DeviceSnapshot: record index out of range");
+    const Record& record = records()[t_index];
+    validate(record,t_index);
+    return record;
+}
+
+const DeviceSnapshot::Record* DeviceSnapshot::findById(int t_id) const
+{
+    //touches about log2(size) records, i.e. a handful of pages even for millions of devices
+    const Record* first = records();
+    const Record* last = first+m_record_count;
+    const Record* found = std::lower_bound(first,last,t_id,[](const Record& t_record,int t_value){return t_record.id<t_value;});
+    if(found==last || found->id!=t_id)
+        return nullptr;
+    validate(*found,static_cast<std::size_t>(found-first));
+    return found;
+}
+
+const BYTE* DeviceSnapshot::data(const Record& t_record) const
+{
+    if(!hasBuffers())
+        return nullptr;
+    return m_mapping+m_data_offset+t_record.data_offset;
+}
+
+void DeviceSnapshot::adoptIdCounter() const
+{
+    //the saved counter may be behind devices created with an explicit id: the records are sorted,
+    //the last one holds the highest id
+    int next = m_next_device_id;
+    if(m_record_count>0)
+    {
+        const int last_id = record(m_record_count-1).id;
+        if(last_id>=next)
+        {
+            if(last_id==std::numeric_limits<int>::max())
+                throw std::overflow_error("DeviceSnapshot: no device id left after the snapshot ids");
+            next = last_id+1;
+        }
+    }
+    int current = Device::next_device_id.load();
+    while(current<next && !Device::next_device_id.compare_exchange_weak(current,next))
+    {
+    }
+}
+
+DeviceHandle DeviceSnapshot::restore(const Record& t_record,DeviceRegistry& t_registry) const
+{
+    DeviceHandle handle = t_registry.emplace(t_record.id,t_record.getTypeCode(),t_record.getStatusCode(),
+                                             DATA_SIZE{t_record.buffer_capacity});
+    if(t_record.data_size)
+        t_registry.find(handle)->write_n(data(t_record),t_record.data_size);
+    return handle;
+}
+
+void DeviceSnapshot::restoreAll(DeviceRegistry& t_registry) const
+{
+    adoptIdCounter();
+    ::madvise(const_cast<unsigned char*>(m_mapping),m_mapping_size,MADV_SEQUENTIAL);
+    for(std::size_t i=0;i<m_record_count;++i)
+        restore(record(i),t_registry);
+}
@@ -0,0 +1,87 @@
+#ifndef DEVICE_SNAPSHOT_H
+#define DEVICE_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "device_registry.h"
+
+//Versioned on-disk snapshot of a device set, read back through a read-only mmap for a warm restart.
+//
+//File layout (integers in host byte order):
+//  header   64 bytes: "DSNP" | u16 version | u16 flags | u32 record size | u32 header check | u64 record count
+//           | i64 next_device_id | u64 records offset | u64 data offset | u64 data size | 8 reserved bytes
+//  records  fixed-size Record array sorted by device id
+//  data     buffered bytes of the devices (only with FLAG_BUFFERS)
+//
+//Opening a snapshot maps the file and checks the header only. A record is validated when it is accessed
+//(its check value, enum ranges and data range), so the cost of a restart follows the pages actually
+//touched, not the number of devices: a lookup by id is a binary search over the mapped records.
+class DeviceSnapshot{
+public:
+    static const std::uint16_t FORMAT_VERSION = 1;
+    static const std::uint16_t FLAG_BUFFERS = 1;
+
+    //one device, as stored in the file
+    struct Record{
+        std::int32_t id;
+        std::uint8_t type;
+        std::uint8_t status;
+        std::uint16_t reserved;
+        std::uint32_t buffer_capacity;
+        std::uint32_t data_size;            //buffered bytes saved in the data section
+        std::uint64_t data_offset;          //from the start of the data section
+        std::uint32_t check;                //of the fields above, see DeviceSnapshot::recordCheck
+        std::uint32_t reserved2;
+
+        DEVICE_TYPE getTypeCode() const {return static_cast<DEVICE_TYPE>(type);}
+        DEVICE_STATUS getStatusCode() const {return static_cast<DEVICE_STATUS>(status);}
+    };
+    static_assert(sizeof(Record)==32,"the record layout is part of the file format");
+
+    //writes a snapshot of every device (and of the Device::next_device_id counter) to t_path.
+    //The file is written next to t_path and renamed over it, so a crash never leaves a torn snapshot.
+    //Buffered bytes are read with Device::peek_n: no producer may write to the devices meanwhile.
+    static void save(const std::string& t_path,const DeviceRegistry& t_registry,bool t_include_buffers=false);
+
+    //maps t_path and validates its header, throws std::system_error or std::runtime_error
+    explicit DeviceSnapshot(const std::string& t_path);
+    DeviceSnapshot(const DeviceSnapshot&)=delete;
+    DeviceSnapshot& operator=(const DeviceSnapshot&)=delete;
+    ~DeviceSnapshot();
+
+    std::size_t size() const {return m_record_count;}
+    bool hasBuffers() const {return (m_flags&FLAG_BUFFERS)!=0;}
+    int nextDeviceId() const {return m_next_device_id;}
+
+    //validated on access: std::out_of_range for a bad index, std::runtime_error for a corrupt record
+    const Record& record(std::size_t t_index) const;
+    //nullptr if the id is not in the snapshot
+    const Record* findById(int t_id) const;
+    //the saved buffered bytes of a record (t_record.data_size of them), nullptr without FLAG_BUFFERS
+    const BYTE* data(const Record& t_record) const;
+
+    //moves Device::next_device_id past every id of the snapshot, so new devices never reuse one
+    void adoptIdCounter() const;
+    //materializes one device (with its saved buffered bytes) in t_registry
+    DeviceHandle restore(const Record& t_record,DeviceRegistry& t_registry) const;
+    //materializes every device and adopts the id counter
+    void restoreAll(DeviceRegistry& t_registry) const;
+
+    static std::uint32_t recordCheck(const Record& t_record);
+
+private:
+    const Record* records() const {return reinterpret_cast<const Record*>(m_mapping+m_records_offset);}
+    void validate(const Record& t_record,std::size_t t_index) const;
+
+    const unsigned char* m_mapping=nullptr;
+    std::size_t m_mapping_size=0;
+    std::uint16_t m_flags=0;
+    std::size_t m_record_count=0;
+    int m_next_device_id=0;
+    std::uint64_t m_records_offset=0;
+    std::uint64_t m_data_offset=0;
+    std::uint64_t m_data_size=0;
+};
+
+#endif // DEVICE_SNAPSHOT_H
@@ -0,0 +1,117 @@
+#include "epoch_reclamation.h"
+#include <stdexcept>
+
+//retirements between two reclaim() attempts
+static const std::size_t RECLAIM_INTERVAL = 64;
+
+EpochManager& EpochManager::global()
+{
+    static EpochManager manager;
+    return manager;
+}
+
+EpochManager::~EpochManager()
+{
+    for(const Retired& retired:m_retired)
+        retired.deleter(retired.object);
+}
+
+EpochManager::Guard::Guard(EpochManager& t_manager):m_manager{t_manager},m_slot{t_manager.threadSlot()}
+{
+    ThreadSlot& slot = m_manager.m_slots[m_slot];
+    if(slot.nesting++==0)
+    {
+        slot.epoch.store(m_manager.m_global_epoch.load(std::memory_order_relaxed),std::memory_order_relaxed);
+        //the announced epoch must be visible before any shared pointer is read
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+EpochManager::Guard::~Guard()
+{
+    ThreadSlot& slot = m_manager.m_slots[m_slot];
+    if(--slot.nesting==0)
+        slot.epoch.store(INACTIVE,std::memory_order_release);
+}
+
+void EpochManager::retire(void* t_object,void (*t_deleter)(void*))
+{
+    bool reclaim_now;
+    {
+        std::lock_guard<std::mutex> lock(m_retired_mutex);
+        m_retired.push_back(Retired{t_object,t_deleter,m_global_epoch.load(std::memory_order_acquire)});
+        reclaim_now = m_retired.size()%RECLAIM_INTERVAL==0;
+    }
+    if(reclaim_now)
+        reclaim();
+}
+
+void EpochManager::reclaim()
+{
+    tryAdvance();
+    const std::uint64_t epoch = m_global_epoch.load(std::memory_order_acquire);
+
+    std::vector<Retired> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_retired_mutex);
+        auto keep = m_retired.begin();
+        for(auto it=m_retired.begin();it!=m_retired.end();++it)
+        {
+            //retired at epoch e: readers pinned at e-1 or e may still see it, readers pinned at e+1 may not
+            if(it->epoch+2<=epoch)
+                ready.push_back(*it);
+            else
+                *keep++ = *it;
+        }
+        m_retired.erase(keep,m_retired.end());
+    }
+    for(const Retired& retired:ready)
+        retired.deleter(retired.object);
+}
+
+std::size_t EpochManager::pendingObjects() const
+{
+    std::lock_guard<std::mutex> lock(m_retired_mutex);
+    return m_retired.size();
+}
+
+bool EpochManager::tryAdvance()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t epoch = m_global_epoch.load(std::memory_order_relaxed);
+    for(const ThreadSlot& slot:m_slots)
+    {
+        const std::uint64_t local = slot.epoch.load(std::memory_order_acquire);
+        if(local!=INACTIVE && local!=epoch)
+            return false;   //a reader is still in an older epoch
+    }
+    return m_global_epoch.compare_exchange_strong(epoch,epoch+1,std::memory_order_acq_rel);
+}
+
+//every thread claims one slot per manager on first use and gives it back when it exits
+std::size_t EpochManager::threadSlot()
+{
+    struct SlotOwner{
+        std::vector<std::pair<EpochManager*,std::size_t>> slots;
+        ~SlotOwner()
+        {
+            for(auto& owned:slots)
+                owned.first->m_slots[owned.second].in_use.store(false,std::memory_order_release);
+        }
+    };
+    thread_local SlotOwner owner;
+    for(auto& owned:owner.slots)
+        if(owned.first==this)
+            return owned.second;
+
+    for(std::size_t i=0;i<MAX_THREADS;++i)
+    {
+        bool expected = false;
+        if(m_slots[i].in_use.compare_exchange_strong(expected,true,std::memory_order_acq_rel))
+        {
+            owner.slots.emplace_back(this,i);
+            return i;
+        }
+    }
+    throw std::runtime_error("EpochManager: more than MAX_THREADS concurrent threads");
+}
@@ -0,0 +1,79 @@
+#ifndef EPOCH_RECLAMATION_H
+#define EPOCH_RECLAMATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//Epoch based memory reclamation for lock-free readers (RCU style).
+//A reader pins the current epoch while it follows shared pointers; a writer that unlinks an object
+//retires it instead of deleting it. The object is deleted once the global epoch has advanced twice
+//past its retirement, i.e. when no reader can still hold a pointer to it.
+class EpochManager{
+public:
+    static const std::size_t MAX_THREADS = 256;
+
+    //the process wide manager: thread slots are tied to it, so there is no other instance
+    static EpochManager& global();
+
+    EpochManager(const EpochManager&)=delete;
+    EpochManager& operator=(const EpochManager&)=delete;
+    //frees everything still retired: no reader may be active any more
+    ~EpochManager();
+
+    //RAII read-side critical section: pointers read from lock-free structures stay valid while it lives
+    class Guard{
+    public:
+        explicit Guard(EpochManager& t_manager);
+        ~Guard();
+        Guard(const Guard&)=delete;
+        Guard& operator=(const Guard&)=delete;
+    private:
+        EpochManager& m_manager;
+        std::size_t m_slot;
+    };
+
+    //defers t_deleter(t_object) until no pinned reader can see t_object
+    void retire(void* t_object,void (*t_deleter)(void*));
+
+    template<typename T>
+    void retire(T* t_object)
+    {
+        retire(t_object,[](void* t_p){delete static_cast<T*>(t_p);});
+    }
+
+    //tries to advance the epoch and frees what became unreachable; retire() calls it periodically
+    void reclaim();
+
+    std::size_t pendingObjects() const;
+
+private:
+    EpochManager()=default;
+
+    static const std::uint64_t INACTIVE = ~std::uint64_t(0);
+
+    struct alignas(64) ThreadSlot{
+        std::atomic<std::uint64_t> epoch{INACTIVE};
+        std::atomic<bool> in_use{false};
+        std::uint32_t nesting=0;        //only touched by the owning thread
+    };
+
+    struct Retired{
+        void* object;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    std::size_t threadSlot();
+    bool tryAdvance();
+
+    ThreadSlot m_slots[MAX_THREADS];
+    std::atomic<std::uint64_t> m_global_epoch{1};
+
+    mutable std::mutex m_retired_mutex;
+    std::vector<Retired> m_retired;
+};
+
+#endif // EPOCH_RECLAMATION_H
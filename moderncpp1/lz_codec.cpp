@@ -0,0 +1,150 @@
+#include "lz_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace{
+
+const std::size_t MIN_MATCH = 4;
+const std::size_t MAX_OFFSET = 65535;
+const unsigned HASH_BITS = 12;
+
+std::uint32_t load32(const std::uint8_t* t_bytes)
+{
+    std::uint32_t value;
+    std::memcpy(&value,t_bytes,sizeof(value));
+    return value;
+}
+
+std::uint32_t hash4(const std::uint8_t* t_bytes)
+{
+    return (load32(t_bytes)*2654435761u)>>(32-HASH_BITS);
+}
+
+//writes the 255-continued part of a length, returns false if it does not fit
+bool writeLength(std::uint8_t*& t_output,const std::uint8_t* t_end,std::size_t t_length)
+{
+    for(;;)
+    {
+        if(t_output==t_end)
+            return false;
+        if(t_length<255)
+        {
+            *t_output++ = static_cast<std::uint8_t>(t_length);
+            return true;
+        }
+        *t_output++ = 255;
+        t_length -= 255;
+    }
+}
+
+//one sequence: t_literal_count literals, then a match (t_match_length 0: last sequence, literals only)
+bool writeSequence(std::uint8_t*& t_output,const std::uint8_t* t_end,const std::uint8_t* t_literals,std::size_t t_literal_count,
+                   std::size_t t_offset,std::size_t t_match_length)
+{
+    if(t_output==t_end)
+        return false;
+    std::uint8_t& token = *t_output++;
+    const std::size_t match_code = t_match_length ? t_match_length-MIN_MATCH : 0;
+    token = static_cast<std::uint8_t>(std::min<std::size_t>(t_literal_count,15)<<4 | std::min<std::size_t>(match_code,15));
+    if(t_literal_count>=15 && !writeLength(t_output,t_end,t_literal_count-15))
+        return false;
+    if(static_cast<std::size_t>(t_end-t_output)<t_literal_count)
+        return false;
+    if(t_literal_count>0)
+        std::memcpy(t_output,t_literals,t_literal_count);
+    t_output += t_literal_count;
+    if(t_match_length==0)
+        return true;
+    if(t_end-t_output<2)
+        return false;
+    *t_output++ = static_cast<std::uint8_t>(t_offset);
+    *t_output++ = static_cast<std::uint8_t>(t_offset>>8);
+    return match_code<15 || writeLength(t_output,t_end,match_code-15);
+}
+
+//reads the 255-continued part of a length
+std::size_t readLength(const std::uint8_t*& t_input,const std::uint8_t* t_end)
+{
+    std::size_t length = 0;
+    for(;;)
+    {
+        if(t_input==t_end)
+            throw std::runtime_error("LzCodec: truncated block");
+        const std::uint8_t byte = *t_input++;
+        length += byte;
+        if(byte!=255)
+            return length;
+    }
+}
+
+}
+
+std::size_t LzCodec::compress(const std::uint8_t* t_input,std::size_t t_size,std::uint8_t* t_output,std::size_t t_capacity)
+{
+    //positions (+1, 0 is empty) of the last 4-byte sequences seen, by hash
+    std::uint32_t table[1u<<HASH_BITS] = {};
+    std::uint8_t* output = t_output;
+    const std::uint8_t* output_end = t_output+t_capacity;
+    std::size_t literal_start = 0;
+    std::size_t position = 0;
+    while(t_size>=MIN_MATCH && position<=t_size-MIN_MATCH)
+    {
+        const std::uint32_t hash = hash4(t_input+position);
+        const std::size_t candidate = table[hash];
+        table[hash] = static_cast<std::uint32_t>(position+1);
+        if(candidate==0 || position-(candidate-1)>MAX_OFFSET || load32(t_input+candidate-1)!=load32(t_input+position))
+        {
+            ++position;
+            continue;
+        }
+        const std::size_t match = candidate-1;
+        std::size_t length = MIN_MATCH;
+        while(position+length<t_size && t_input[match+length]==t_input[position+length])
+            ++length;
+        if(!writeSequence(output,output_end,t_input+literal_start,position-literal_start,position-match,length))
+            return 0;
+        position += length;
+        literal_start = position;
+    }
+    if(!writeSequence(output,output_end,t_input+literal_start,t_size-literal_start,0,0))
+        return 0;
+    return static_cast<std::size_t>(output-t_output);
+}
+
+std::size_t LzCodec::decompress(const std::uint8_t* t_input,std::size_t t_size,std::uint8_t* t_output,std::size_t t_capacity)
+{
+    const std::uint8_t* input = t_input;
+    const std::uint8_t* input_end = t_input+t_size;
+    std::size_t written = 0;
+    while(input<input_end && written<t_capacity)
+    {
+        const std::uint8_t token = *input++;
+        std::size_t literal_count = token>>4;
+        if(literal_count==15)
+            literal_count += readLength(input,input_end);
+        if(static_cast<std::size_t>(input_end-input)<literal_count)
+            throw std::runtime_error("LzCodec: truncated block");
+        const std::size_t literals = std::min(literal_count,t_capacity-written);
+        std::memcpy(t_output+written,input,literals);
+        written += literals;
+        input += literal_count;
+        if(input==input_end || written==t_capacity)
+            break;
+
+        if(input_end-input<2)
+            throw std::runtime_error("LzCodec: truncated block");
+        const std::size_t offset = input[0] | static_cast<std::size_t>(input[1])<<8;
+        input += 2;
+        std::size_t length = (token&15u)+MIN_MATCH;
+        if((token&15u)==15)
+            length += readLength(input,input_end);
+        if(offset==0 || offset>written)
+            throw std::runtime_error("LzCodec: corrupt match offset");
+        //byte by byte: a match may overlap the bytes it produces (offset < length repeats a pattern)
+        const std::size_t end = std::min(written+length,t_capacity);
+        for(;written<end;++written)
+            t_output[written] = t_output[written-offset];
+    }
+    return written;
+}
@@ -0,0 +1,27 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+//Small LZ77 byte codec (LZ4-style block format), no dependency and no allocation: fast enough to run on
+//every idle device buffer, good ratios on the repetitive text and telemetry frames devices buffer.
+//
+//Block format: a list of sequences, each
+//  token (1 byte: literal count in the high nibble, match length-4 in the low nibble, 15 = more bytes follow)
+//  | extra literal count bytes (255 = more follow) | literals | u16 little-endian match offset
+//  | extra match length bytes (255 = more follow)
+//The last sequence has literals only: it ends with the block.
+class LzCodec{
+public:
+    //compresses t_size bytes into t_output, returns the compressed size,
+    //or 0 if the result would not fit in t_capacity bytes (the input is not compressible enough)
+    static std::size_t compress(const std::uint8_t* t_input,std::size_t t_size,std::uint8_t* t_output,std::size_t t_capacity);
+
+    //decompresses a block, writing at most t_capacity bytes: decoding stops once t_output is full,
+    //so the first bytes of a block can be read without decoding all of it.
+    //Returns the number of bytes written; throws std::runtime_error on a corrupt block.
+    static std::size_t decompress(const std::uint8_t* t_input,std::size_t t_size,std::uint8_t* t_output,std::size_t t_capacity);
+};
+
+#endif // LZ_CODEC_H
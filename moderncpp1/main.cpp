@@ -9,36 +9,78 @@
  * 7- nested standard container initialization (e.g. std::map device_type_labels and device_status_labels)
  * 8- explicit identifier usage in class Constructor
  * 9- implementing move semantics : move contructor and move assignment operator
+ * 10- slot map based DeviceRegistry: devices stored by value, generation-checked handles and O(1) lookup by id
+ * 11- polymorphic memory resources (std::pmr): a whole batch of device buffers served by one arena
+ * 12- lock-free single-producer/single-consumer ring buffer I/O on the device buffer (std::atomic)
+ * 13- bitmap query index: type/status filters answered with word-wide AND/OR and popcount
+ * 14- C++20 coroutines: co_await read/write on fd-backed devices, driven by a single-threaded epoll reactor
+ * 15- lock-free status state machine (compare-and-swap) with change notifications delivered in batches
+ * 16- memory-mapped registry snapshot: a restart looks devices up in the mapped file instead of rebuilding them
+ * 17- work-stealing thread pool: per-device service jobs spread over every core, uneven costs balanced by stealing
+ * 18- hot/cold data split: a compact 32-byte Device record for scans, rarely used data in a store keyed by the Device object
+ * 19- per-thread latency histograms (HDR-style buckets) merged on demand into p50/p99/p99.9/max per operation
+ * 20- transparent compression of idle device buffers (built-in LZ codec), decompressed lazily on the next access
  */
 
+#include<atomic>
+#include<cstdio>
 #include<memory>
-#include<vector>
 #include<iostream>
+#include <sys/socket.h>
+#include "../Common/latency_histogram.h"
+#include "async_device.h"
+#include "buffer_compressor.h"
 #include "device.h"
+#include "device_registry.h"
+#include "device_snapshot.h"
+#include "memory_resources.h"
+#include "status_notifier.h"
+#include "work_stealing_pool.h"
+
+//Prints the device event log (bounded, oldest event first)
+void printDeviceComments(const Device& t_device){
+    for(const DeviceEvent& event:t_device.getEvents())
+        std::cout<<"\n"<<event.message();
+}
 
 //Sample object accessor function based on object Reference
 void printDeviceInfo(Device& t_device){
     std::cout<<"device (id,status): "<< t_device.getId()<<","<<t_device.getStatusLabel()<<std::endl;
-    std::cout<<"device Comment: "<< t_device.getComment()<<std::endl;
+    std::cout<<"device Comment: ";
+    printDeviceComments(t_device);
+    std::cout<<std::endl;
     t_device.addCommentToDevice("Request to Print Device Info DONE");
 }
 
 //Sample object accessor function based on unique_ptr reference
 void printDeviceInfo(const std::unique_ptr<Device>& t_device_ptr){
-    std::cout<<"device (id,status): "<< t_device_ptr->getId()<<","<<t_device_ptr->getStatusLabel()<<std::endl;
-    std::cout<<"device Comment: "<< t_device_ptr->getComment()<<std::endl;
-    t_device_ptr->addCommentToDevice("Request to Print Device Info DONE");
+    printDeviceInfo(*t_device_ptr);
 }
 
-//smart std::unique_pointer usage
-std::unique_ptr<Device> createDevice(DEVICE_TYPE t_type,DEVICE_STATUS t_status)
-{
-    return std::make_unique<Device>(Device(t_type,t_status,32));
+//coroutine side of a printer: answers every job with an acknowledgement, until the host hangs up
+Task<void> printerLoop(AsyncDevice& t_printer){
+    BYTE job[64];
+    while(DATA_SIZE size = co_await t_printer.read(job,sizeof(job)))
+    {
+        std::cout<<"Printer #"<<t_printer.device().getId()<<" got: "<<std::string(job,job+size)<<std::endl;
+        const BYTE ack[]={'a','c','k'};
+        co_await t_printer.write(ack,sizeof(ack));
+    }
+}
+
+//coroutine side of the host: sends a job, waits for the acknowledgement, then closes its end
+Task<void> hostLoop(AsyncDevice& t_host){
+    const BYTE job[]={'p','a','g','e','-','1'};
+    co_await t_host.write(job,sizeof(job));
+    BYTE ack[8];
+    DATA_SIZE size = co_await t_host.read(ack,sizeof(ack));
+    std::cout<<"Host got: "<<std::string(ack,ack+size)<<std::endl;
+    ::shutdown(t_host.fd(),SHUT_WR);
 }
 
 int main(int argc, char *argv[])
 {
-    std::vector<std::unique_ptr<Device>> device_list;
+    DeviceRegistry device_list;
     //auto data type
     auto ptr = createDevice(GPIO,IDLE);
 
@@ -53,30 +95,94 @@ int main(int argc, char *argv[])
 
     printDeviceInfo(ptr);
 
-    device_list.push_back(std::move(ptr));
-    std::cout<<"Device Object Comment after printInfo invokation: "<<device_list[0]->getComment()<<std::endl;
+    //the registry stores devices by value: the unique_ptr content is moved into a registry slot
+    DeviceHandle first_device = device_list.emplace(std::move(*ptr));
+    ptr.reset();
+    std::cout<<"Device Object Comment after printInfo invokation: ";
+    printDeviceComments(*device_list.find(first_device));
+    std::cout<<std::endl;
 
-    std::cout<<"Adding 4 more devices to the device list vector . . ."<<std::endl;
-    device_list.push_back(createDevice(KEYBOARD,STOPPED));
-    device_list.push_back(createDevice(MOUSE,STOPPED));
-    device_list.push_back(createDevice(DISPLAY,IDLE));
-    device_list.push_back(createDevice(PRINTER,IDLE));
+    std::cout<<"Adding 4 more devices to the device registry . . ."<<std::endl;
+    //devices are constructed in place inside the registry, no temporary and no move
+    device_list.emplace(KEYBOARD,STOPPED,32);
+    device_list.emplace(MOUSE,STOPPED,32);
+    DeviceHandle display = device_list.emplace(DISPLAY,IDLE,32);
+    device_list.emplace(PRINTER,IDLE,32);
 
-    device_list.push_back(std::make_unique<Device>(256));
+    device_list.emplace(DATA_SIZE{256});
 
 
-    std::cout<<"Listing all " << device_list.size()<<" devices to the device list vector . . ."<<std::endl;
+    std::cout<<"Listing all " << device_list.size()<<" devices in the device registry . . ."<<std::endl;
 
 
     //range-based for loop and auto data type
     for(const auto& device:device_list)
     {
-        std::cout<<"Device #"<<device->getId()<<" -> Type: "<<device->getTypeLabel()
-                <<" -> Status: "<<device->getStatusLabel()<<std::endl;
+        std::cout<<"Device #"<<device.getId()<<" -> Type: "<<device.getTypeLabel()
+                <<" -> Status: "<<device.getStatusLabel()<<std::endl;
+    }
+
+    //status changes go through the registry so its bitmap index follows, queries never scan the devices
+    //subscribers get the changes in batches, one call for all the changes made since the previous batch
+    StatusNotifier notifier;
+    notifier.subscribe([](const std::vector<StatusChange>& t_batch){
+        for(const StatusChange& change:t_batch)
+            std::cout<<"Device #"<<change.device_id<<": "<<Device::statusLabel(change.from)<<" -> "
+                     <<Device::statusLabel(change.to)<<" ("<<change.transitions<<" transition(s))"<<std::endl;
+    });
+    device_list.setStatusNotifier(&notifier);
+    device_list.setStatus(display,FAULT);
+    //transitions are checked: a FAULT device has to restart (STARTING) before it can be READY again
+    std::cout<<"FAULT -> READY allowed: "<<std::boolalpha<<device_list.setStatus(display,READY)<<std::endl;
+    notifier.flush();
+    device_list.setStatusNotifier(nullptr);
+    std::cout<<"FAULT displays: "<<device_list.count(DeviceQuery().type(DISPLAY).status(FAULT))<<std::endl;
+    const auto stopped_per_type = device_list.countByType(STOPPED);
+    for(int t=0;t<DEVICE_TYPE_COUNT;++t)
+        if(stopped_per_type[t])
+            std::cout<<"STOPPED "<<Device::typeLabel(static_cast<DEVICE_TYPE>(t))<<": "<<stopped_per_type[t]<<std::endl;
+    device_list.forEachMatch(DeviceQuery().status(IDLE).status(FAULT),[](const Device& t_device){
+        std::cout<<"Device #"<<t_device.getId()<<" needs attention: "<<t_device.getStatusLabel()<<std::endl;
+    });
+
+    //O(1) lookup by id instead of a linear search
+    const int display_id = device_list.find(display)->getId();
+    std::cout<<"Lookup device #"<<display_id<<" by id -> Type: "<<device_list.findById(display_id)->getTypeLabel()<<std::endl;
+
+    //warm restart: save the registry, map the snapshot back and read a device straight from the file
+    const std::string snapshot_path = "/tmp/moderncpp1_devices.dsnp";
+    DeviceSnapshot::save(snapshot_path,device_list);
+    {
+        DeviceSnapshot snapshot(snapshot_path);
+        const DeviceSnapshot::Record* record = snapshot.findById(display_id);
+        std::cout<<"Snapshot of "<<snapshot.size()<<" devices, device #"<<record->id<<" -> Status: "
+                 <<Device::statusLabel(record->getStatusCode())<<std::endl;
     }
+    std::remove(snapshot_path.c_str());
+
+    //device buffer I/O: the display buffer works as a ring, a producer thread could write while a consumer reads
+    Device* display_device = device_list.find(display);
+    const BYTE frame[]={'f','r','a','m','e'};
+    display_device->write_n(frame,sizeof(frame));
+    BYTE received[8]{};
+    DATA_SIZE received_size = display_device->read_n(received,sizeof(received));
+    std::cout<<"Display received "<<received_size<<" bytes: "<<std::string(received,received+received_size)<<std::endl;
+
+    //servicing every device in parallel: idle pool threads steal work from busy ones
+    WorkStealingPool pool;
+    std::atomic<DATA_SIZE> buffer_capacity{0};
+    device_list.parallelForEach(pool,[&](const Device& t_device){
+        buffer_capacity.fetch_add(t_device.getBufferCapacity(),std::memory_order_relaxed);
+    });
+    std::cout<<"Polled "<<device_list.size()<<" devices on "<<pool.threadCount()<<" thread(s): "
+             <<buffer_capacity.load()<<" bytes of buffer capacity"<<std::endl;
+
+    //only the hot fields are in the Device: the event logs sit in the cold store, one per commented device
+    std::cout<<"sizeof(Device): "<<sizeof(Device)<<" bytes, "<<DeviceColdStore::global().size()
+             <<" event log(s) in the cold store"<<std::endl;
 
     //inhvoking Copy Assignment operator and Copy Constructor
-    Device a = *device_list[0];
+    Device a = *device_list.find(first_device);
 
     //inhvoking Move Assignment operator cause a to reset data
     Device b = std::move(a);
@@ -85,20 +191,84 @@ int main(int argc, char *argv[])
     std::cout<<"----------------------------------------------------"<<std::endl;
     std::cout<<"Now Modify Devices List"<<std::endl;
 
-    //Invoking Move Constructor
-    device_list[0] = std::make_unique<Device>(Device(128));
+    //erasing a device never moves the others, and its stale handle is detected afterwards
+    device_list.erase(first_device);
+    std::cout<<"Erased first device, handle still valid: "<<std::boolalpha<<(device_list.find(first_device)!=nullptr)<<std::endl;
+
+    //Invoking Move Constructor (the freed slot is reused)
+    device_list.emplace(Device(128));
 
-    //Invoking Copy Constructor
-    device_list.push_back(std::make_unique<Device>(b));
+    //Invoking Copy Constructor: the copy keeps b's id, which is free again since the first device was erased
+    device_list.emplace(b);
 
     //range-based for loop and auto data type
     for(const auto& device:device_list)
     {
-        std::cout<<"Device #"<<device->getId()<<" -> Type: "<<device->getTypeLabel()
-                <<" -> Status: "<<device->getStatusLabel()<<std::endl;
+        std::cout<<"Device #"<<device.getId()<<" -> Type: "<<device.getTypeLabel()
+                <<" -> Status: "<<device.getStatusLabel()<<std::endl;
     }
 
     device_list.clear();
 
+    std::cout<<"----------------------------------------------------"<<std::endl;
+    //std::pmr: the arena takes a single allocation from the counting (global heap) resource for the whole batch
+    CountingResource heap;
+    {
+        DeviceArenaResource arena(1000,DEFAULT_BUFFER_CAPACITY,&heap);
+        DeviceRegistry batch(1000);
+        for(int i=0;i<1000;++i)
+            batch.emplace(PRINTER,READY,DEFAULT_BUFFER_CAPACITY,&arena);
+        batch.clear();
+    }
+    std::cout<<"1000 devices created and destroyed with "<<heap.allocations()<<" heap allocation(s) for their buffers"<<std::endl;
+
+    std::cout<<"----------------------------------------------------"<<std::endl;
+    //async device I/O: a socketpair stands in for the printer port, both ends are coroutines on one thread
+    {
+        int fds[2];
+        if(::socketpair(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0,fds)==0)
+        {
+            Device printer(PRINTER,READY,DEFAULT_BUFFER_CAPACITY);
+            Device host(GPIO,READY,DEFAULT_BUFFER_CAPACITY);
+            Reactor reactor;
+            AsyncDevice printer_port(reactor,printer,fds[0]);
+            AsyncDevice host_port(reactor,host,fds[1]);
+            reactor.spawn(printerLoop(printer_port));
+            reactor.spawn(hostLoop(host_port));
+            reactor.run();
+        }
+    }
+
+    std::cout<<"----------------------------------------------------"<<std::endl;
+    //idle compression: a printer left IDLE with a full buffer of status text gets compressed by the periodic sweep
+    {
+        DeviceRegistry parked;
+        const DeviceHandle printer = parked.emplace(PRINTER,IDLE,1024);
+        std::string status_text;
+        while(status_text.size()<1000)
+            status_text += "page "+std::to_string(status_text.size()/32)+" done, toner ok\n";
+        parked.find(printer)->write_n(reinterpret_cast<const BYTE*>(status_text.data()),1000);
+
+        BufferCompressor compressor(std::chrono::minutes(5));
+        const auto now = std::chrono::steady_clock::now();
+        compressor.sweep(parked,now);                               //starts the idle time
+        compressor.sweep(parked,now+std::chrono::minutes(5));       //idle for long enough: compressed
+        const BufferCompressionStats stats = BufferCompressor::stats();
+        std::cout<<"Idle printer buffer compressed: "<<std::boolalpha<<parked.find(printer)->isBufferCompressed()
+                 <<", "<<stats.bytes_saved<<" bytes saved"<<std::endl;
+
+        //the next read decompresses it
+        BYTE first_line[22];        //"page 0 done, toner ok\n"
+        const DATA_SIZE size = parked.find(printer)->read_n(first_line,sizeof(first_line));
+        std::cout<<"Read back \""<<std::string(reinterpret_cast<const char*>(first_line),size-1)
+                 <<"\", compressed: "<<parked.find(printer)->isBufferCompressed()<<std::endl;
+    }
+
+    //built with LATENCY_HISTOGRAMS=1: latency percentiles of the instrumented operations (prints nothing otherwise)
+    latency::writeText(std::cout);
+
+    //in LIFECYCLE_TRACE_RING mode the constructor/assignment messages were buffered: print them now
+    lifecycle::dump();
+
     return 0;
 }
@@ -0,0 +1,89 @@
+#ifndef MEMORY_RESOURCES_H
+#define MEMORY_RESOURCES_H
+
+#include <cstddef>
+#include <memory_resource>
+#include "device.h"
+
+//Ready-made std::pmr memory resources for device buffers.
+//Pass one of them as the last constructor argument of Device (or DataBuffer) to take buffer allocations
+//off the global heap. Like every std::pmr resource, a resource must outlive the objects using it.
+
+//Size-class pool: small buffers are served from per-size free lists (pools of 8, 16, 32 ... bytes)
+//refilled in chunks from the upstream resource, so create/destroy churn reuses memory instead of
+//calling malloc/free. Not thread-safe: use one pool per thread, or std::pmr::synchronized_pool_resource.
+class DevicePoolResource : public std::pmr::unsynchronized_pool_resource{
+public:
+    //t_largest_buffer: buffers up to this size are pooled, bigger ones go straight to the upstream resource
+    explicit DevicePoolResource(std::size_t t_largest_buffer=4096,
+                                std::pmr::memory_resource* t_upstream=std::pmr::get_default_resource())
+        :std::pmr::unsynchronized_pool_resource(poolOptions(t_largest_buffer),t_upstream){}
+
+private:
+    static std::pmr::pool_options poolOptions(std::size_t t_largest_buffer)
+    {
+        std::pmr::pool_options options;
+        options.largest_required_pool_block = t_largest_buffer;
+        options.max_blocks_per_chunk = 1024;
+        return options;
+    }
+};
+
+//Monotonic arena for a batch of devices: allocation is a pointer bump and deallocation is a no-op.
+//Sized up front for the whole batch, it takes a single allocation from upstream; release() or the
+//arena destructor frees the batch at once after the devices are gone.
+class DeviceArenaResource : public std::pmr::monotonic_buffer_resource{
+public:
+    DeviceArenaResource(std::size_t t_device_count,DATA_SIZE t_buffer_capacity=DEFAULT_BUFFER_CAPACITY,
+                        std::pmr::memory_resource* t_upstream=std::pmr::get_default_resource())
+        :std::pmr::monotonic_buffer_resource(arenaSize(t_device_count,t_buffer_capacity),t_upstream){}
+
+private:
+    static std::size_t arenaSize(std::size_t t_device_count,DATA_SIZE t_buffer_capacity)
+    {
+        //round every buffer (ring header included) up to the alignment Device requests
+        const std::size_t align = Device::BUFFER_ALIGNMENT;
+        const std::size_t buffer_size = (Device::bufferAllocationSize(t_buffer_capacity)+align-1)/align*align;
+        return t_device_count*buffer_size + align;
+    }
+};
+
+//Pass-through resource that counts the allocations reaching it, handy to check that a pool/arena
+//really took the traffic away from the upstream (global) allocator.
+class CountingResource : public std::pmr::memory_resource{
+public:
+    explicit CountingResource(std::pmr::memory_resource* t_upstream=std::pmr::get_default_resource())
+        :m_upstream{t_upstream}{}
+
+    std::size_t allocations() const {return m_allocations;}
+    std::size_t deallocations() const {return m_deallocations;}
+    std::size_t bytesInUse() const {return m_bytes_in_use;}
+
+private:
+    void* do_allocate(std::size_t t_bytes,std::size_t t_alignment) override
+    {
+        void* p = m_upstream->allocate(t_bytes,t_alignment);
+        ++m_allocations;
+        m_bytes_in_use += t_bytes;
+        return p;
+    }
+
+    void do_deallocate(void* t_p,std::size_t t_bytes,std::size_t t_alignment) override
+    {
+        m_upstream->deallocate(t_p,t_bytes,t_alignment);
+        ++m_deallocations;
+        m_bytes_in_use -= t_bytes;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& t_other) const noexcept override
+    {
+        return this==&t_other;
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    std::size_t m_allocations=0;
+    std::size_t m_deallocations=0;
+    std::size_t m_bytes_in_use=0;
+};
+
+#endif // MEMORY_RESOURCES_H
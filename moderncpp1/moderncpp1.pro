@@ -1,4 +1,4 @@
-CONFIG += c++17 console
+CONFIG += c++2a console
 CONFIG -= qt app_bundle
 
 # The following define makes your compiler emit warnings if you use
@@ -12,9 +12,26 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Per-operation latency histograms (../Common/latency_histogram.h), printed at exit
+#DEFINES += LATENCY_HISTOGRAMS=1
+
 SOURCES += \
+        async_device.cpp \
+        buffer_compressor.cpp \
+        concurrent_device_registry.cpp \
         device.cpp \
-        main.cpp
+        device_bitmap_index.cpp \
+        device_cold_store.cpp \
+        device_registry.cpp \
+        device_snapshot.cpp \
+        epoch_reclamation.cpp \
+        lz_codec.cpp \
+        main.cpp \
+        reactor.cpp \
+        status_notifier.cpp \
+        string_interner.cpp \
+        telemetry_exporter.cpp \
+        work_stealing_pool.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -22,4 +39,22 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
-    device.h
+    async_device.h \
+    buffer_compressor.h \
+    concurrent_device_registry.h \
+    device.h \
+    device_bitmap_index.h \
+    device_cold_store.h \
+    device_event_log.h \
+    device_registry.h \
+    device_snapshot.h \
+    epoch_reclamation.h \
+    lz_codec.h \
+    memory_resources.h \
+    reactor.h \
+    slot_map.h \
+    status_notifier.h \
+    string_interner.h \
+    task.h \
+    telemetry_exporter.h \
+    work_stealing_pool.h
@@ -0,0 +1,178 @@
+#include "reactor.h"
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+//Coroutine wrapper that owns a spawned Task: started by the loop, frees itself when the task is over
+struct Reactor::DetachedTask{
+    struct promise_type{
+        DetachedTask get_return_object()
+        {
+            return DetachedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept {return {};}
+        //the frame is unregistered from its reactor and destroyed at its final suspension point
+        struct Release{
+            bool await_ready() noexcept {return false;}
+            void await_suspend(std::coroutine_handle<promise_type> t_handle) noexcept
+            {
+                t_handle.promise().reactor->m_detached.erase(t_handle.address());
+                t_handle.destroy();
+            }
+            void await_resume() noexcept {}
+        };
+        Release final_suspend() noexcept {return {};}
+        void return_void() {}
+        void unhandled_exception() {std::terminate();}  //runDetached catches everything
+        Reactor* reactor=nullptr;
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+Reactor::Reactor()
+    :m_epoll_fd{::epoll_create1(EPOLL_CLOEXEC)}
+{
+    if(m_epoll_fd<0)
+        throw std::system_error(errno,std::generic_category(),"Reactor: epoll_create1");
+}
+
+Reactor::~Reactor()
+{
+    //frames of unfinished tasks own their Task (and its awaited children): destroying them releases everything
+    for(void* frame:m_detached)
+        std::coroutine_handle<>::from_address(frame).destroy();
+    ::close(m_epoll_fd);
+}
+
+Reactor::DetachedTask Reactor::runDetached(Reactor& t_reactor,Task<void> t_task)
+{
+    std::exception_ptr failure;
+    try
+    {
+        co_await t_task;
+    }
+    catch(...)
+    {
+        failure = std::current_exception();
+    }
+    t_reactor.taskFinished(failure);
+}
+
+void Reactor::spawn(Task<void> t_task)
+{
+    auto handle = runDetached(*this,std::move(t_task)).handle;
+    handle.promise().reactor = this;
+    m_detached.insert(handle.address());
+    m_ready.push_back(handle);
+}
+
+void Reactor::taskFinished(std::exception_ptr t_failure)
+{
+    //called from inside the finishing frame, which is unregistered and destroyed right after
+    if(t_failure && !m_failure)
+    {
+        m_failure = t_failure;
+        m_stopped = true;
+    }
+}
+
+void Reactor::run()
+{
+    m_stopped = false;
+    epoll_event events[256];
+    while(!m_stopped)
+    {
+        while(!m_ready.empty() && !m_stopped)
+        {
+            std::coroutine_handle<> handle = m_ready.front();
+            m_ready.pop_front();
+            handle.resume();
+        }
+        if(m_stopped || m_detached.empty())
+            break;
+
+        int count = ::epoll_wait(m_epoll_fd,events,256,-1);
+        if(count<0)
+        {
+            if(errno==EINTR)
+                continue;
+            throw std::system_error(errno,std::generic_category(),"Reactor: epoll_wait");
+        }
+        for(int i=0;i<count;++i)
+        {
+            Waiters& waiters = m_waiters[static_cast<std::size_t>(events[i].data.fd)];
+            const std::uint32_t ready = events[i].events;
+            //errors and hang-ups wake both sides: the retried syscall reports them
+            if(waiters.reader && (ready&(EPOLLIN|EPOLLRDHUP|EPOLLHUP|EPOLLERR)) && waiters.reader->perform())
+            {
+                m_ready.push_back(waiters.reader->continuation);
+                waiters.reader = nullptr;
+            }
+            if(waiters.writer && (ready&(EPOLLOUT|EPOLLHUP|EPOLLERR)) && waiters.writer->perform())
+            {
+                m_ready.push_back(waiters.writer->continuation);
+                waiters.writer = nullptr;
+            }
+        }
+        m_wakeups += static_cast<std::uint64_t>(count);
+    }
+    if(m_failure)
+        std::rethrow_exception(std::exchange(m_failure,nullptr));
+}
+
+void Reactor::stop()
+{
+    m_stopped = true;
+}
+
+Reactor::Waiters& Reactor::waitersOf(int t_fd)
+{
+    if(t_fd<0)
+        throw std::invalid_argument("Reactor: invalid file descriptor");
+    if(static_cast<std::size_t>(t_fd)>=m_waiters.size())
+        m_waiters.resize(static_cast<std::size_t>(t_fd)+1);
+    return m_waiters[static_cast<std::size_t>(t_fd)];
+}
+
+void Reactor::watch(int t_fd)
+{
+    Waiters& waiters = waitersOf(t_fd);
+    if(waiters.watched)
+        return;
+    epoll_event event{};
+    event.events = EPOLLIN|EPOLLOUT|EPOLLRDHUP|EPOLLET;
+    event.data.fd = t_fd;
+    if(::epoll_ctl(m_epoll_fd,EPOLL_CTL_ADD,t_fd,&event)<0)
+        throw std::system_error(errno,std::generic_category(),"Reactor: epoll_ctl add");
+    waiters.watched = true;
+}
+
+void Reactor::unwatch(int t_fd)
+{
+    if(t_fd<0 || static_cast<std::size_t>(t_fd)>=m_waiters.size() || !m_waiters[static_cast<std::size_t>(t_fd)].watched)
+        return;
+    ::epoll_ctl(m_epoll_fd,EPOLL_CTL_DEL,t_fd,nullptr);
+    m_waiters[static_cast<std::size_t>(t_fd)] = Waiters{};
+}
+
+void Reactor::waitReadable(int t_fd,IoOperation& t_operation)
+{
+    Waiters& waiters = waitersOf(t_fd);
+    if(!waiters.watched)
+        watch(t_fd);
+    if(waiters.reader)
+        throw std::logic_error("Reactor: a read is already pending on this descriptor");
+    waiters.reader = &t_operation;
+}
+
+void Reactor::waitWritable(int t_fd,IoOperation& t_operation)
+{
+    Waiters& waiters = waitersOf(t_fd);
+    if(!waiters.watched)
+        watch(t_fd);
+    if(waiters.writer)
+        throw std::logic_error("Reactor: a write is already pending on this descriptor");
+    waiters.writer = &t_operation;
+}
@@ -0,0 +1,75 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <unordered_set>
+#include <vector>
+#include "task.h"
+
+//A non-blocking I/O operation waiting on a file descriptor (see AsyncDevice).
+//perform() retries the syscall: true once the operation is complete (done or failed), false to keep waiting.
+class IoOperation{
+public:
+    virtual bool perform()=0;
+    std::coroutine_handle<> continuation;
+
+protected:
+    ~IoOperation()=default;
+};
+
+//Single-threaded epoll event loop driving coroutines.
+//File descriptors are registered once, edge-triggered, for both directions: waiting for I/O costs no
+//syscall, only the epoll_wait of the loop does. At most one reader and one writer wait on a descriptor.
+//A Reactor and everything it drives belong to one thread; use one Reactor per thread to spread devices.
+class Reactor{
+public:
+    Reactor();
+    Reactor(const Reactor&)=delete;
+    Reactor& operator=(const Reactor&)=delete;
+    //tasks still suspended on I/O are destroyed with the reactor
+    ~Reactor();
+
+    //starts t_task on the next run(), which keeps the task alive until it finishes
+    void spawn(Task<void> t_task);
+    //runs until every spawned task finished or stop() is called.
+    //The first exception escaping a spawned task stops the loop and is rethrown here.
+    void run();
+    void stop();
+
+    //descriptors must be non-blocking; unwatch before closing a descriptor
+    void watch(int t_fd);
+    void unwatch(int t_fd);
+    //park an operation until the descriptor becomes readable / writable
+    void waitReadable(int t_fd,IoOperation& t_operation);
+    void waitWritable(int t_fd,IoOperation& t_operation);
+
+    std::size_t liveTasks() const {return m_detached.size();}
+    std::uint64_t wakeups() const {return m_wakeups;}
+
+private:
+    struct DetachedTask;
+    static DetachedTask runDetached(Reactor& t_reactor,Task<void> t_task);
+    void taskFinished(std::exception_ptr t_failure);
+
+    //waiting operations, indexed by file descriptor (descriptors are small integers)
+    struct Waiters{
+        IoOperation* reader=nullptr;
+        IoOperation* writer=nullptr;
+        bool watched=false;
+    };
+    Waiters& waitersOf(int t_fd);
+
+    int m_epoll_fd;
+    bool m_stopped=false;
+    std::vector<Waiters> m_waiters;
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::unordered_set<void*> m_detached;  //frame addresses of the spawned tasks not finished yet
+    std::exception_ptr m_failure;
+    std::uint64_t m_wakeups=0;
+};
+
+#endif // REACTOR_H
@@ -0,0 +1,197 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+//Slot map: objects live in fixed-size pages of slots, so an insertion never moves an existing object
+//and a handle (slot index + generation) stays valid until that exact object is erased.
+//Generation parity marks the slot state: odd = occupied, even = free. Erasing bumps the generation,
+//so stale handles to a reused slot are detected instead of silently pointing at another object.
+template<typename T, std::size_t PAGE_SIZE = 1024>
+class SlotMap{
+public:
+    struct Handle{
+        std::uint32_t index=0;
+        std::uint32_t generation=0;     // 0 is never an occupied generation, so Handle{} is always invalid
+
+        bool operator==(const Handle& t_other) const {return index==t_other.index && generation==t_other.generation;}
+        bool operator!=(const Handle& t_other) const {return !(*this==t_other);}
+    };
+
+    SlotMap()=default;
+    SlotMap(const SlotMap&)=delete;
+    SlotMap& operator=(const SlotMap&)=delete;
+    SlotMap(SlotMap&& t_other) noexcept:m_pages{std::move(t_other.m_pages)},m_free_slots{std::move(t_other.m_free_slots)},
+        m_slot_count{std::exchange(t_other.m_slot_count,0)},m_size{std::exchange(t_other.m_size,0)}{}
+    SlotMap& operator=(SlotMap&& t_other)
+    {
+        if(this!=&t_other)
+        {
+            clear();
+            m_pages = std::move(t_other.m_pages);
+            m_free_slots = std::move(t_other.m_free_slots);
+            m_slot_count = std::exchange(t_other.m_slot_count,0);
+            m_size = std::exchange(t_other.m_size,0);
+        }
+        return *this;
+    }
+
+    ~SlotMap(){destroyAll();}
+
+    //constructs the object in place: T does not need to be movable
+    template<typename... Args>
+    Handle emplace(Args&&... t_args)
+    {
+        const bool reuse_slot = !m_free_slots.empty();
+        std::uint32_t index;
+        if(reuse_slot)
+            index = m_free_slots.back();
+        else
+        {
+            if(m_slot_count==m_pages.size()*PAGE_SIZE)
+                m_pages.push_back(std::make_unique<Slot[]>(PAGE_SIZE));
+            index = static_cast<std::uint32_t>(m_slot_count);
+        }
+
+        Slot& slot = slotAt(index);
+        ::new (static_cast<void*>(slot.storage)) T(std::forward<Args>(t_args)...);
+
+        //commit bookkeeping only after the constructor succeeded
+        if(reuse_slot)
+            m_free_slots.pop_back();
+        else
+            ++m_slot_count;
+        ++slot.generation;
+        ++m_size;
+        return Handle{index,slot.generation};
+    }
+
+    T* get(Handle t_handle)
+    {
+        if(!contains(t_handle))
+            return nullptr;
+        return slotAt(t_handle.index).object();
+    }
+
+    const T* get(Handle t_handle) const
+    {
+        return const_cast<SlotMap*>(this)->get(t_handle);
+    }
+
+    bool contains(Handle t_handle) const
+    {
+        return t_handle.index<m_slot_count && (t_handle.generation & 1u)
+                && slotAt(t_handle.index).generation==t_handle.generation;
+    }
+
+    //O(1): destroys the object in place, other objects are never touched
+    bool erase(Handle t_handle)
+    {
+        if(!contains(t_handle))
+            return false;
+        Slot& slot = slotAt(t_handle.index);
+        slot.object()->~T();
+        ++slot.generation;
+        m_free_slots.push_back(t_handle.index);
+        --m_size;
+        return true;
+    }
+
+    //destroys every object but keeps the pages, so refilling the map does not allocate again
+    void clear()
+    {
+        destroyAll();
+        m_free_slots.clear();
+        for(std::size_t i=m_slot_count;i-->0;)
+            m_free_slots.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    std::size_t size() const {return m_size;}
+    bool empty() const {return m_size==0;}
+
+    //number of slots ever handed out (live + free), i.e. the upper bound of slot indexes
+    std::size_t slotCount() const {return m_slot_count;}
+
+    //handle of the object currently living in slot t_index (an invalid handle if the slot is free)
+    Handle handleAt(std::size_t t_index) const
+    {
+        if(t_index>=m_slot_count || !slotAt(t_index).occupied())
+            return Handle{};
+        return Handle{static_cast<std::uint32_t>(t_index),slotAt(t_index).generation};
+    }
+
+    template<typename ValueType, typename MapType>
+    class basic_iterator{
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+        basic_iterator(MapType* t_map,std::size_t t_index):m_map{t_map},m_index{t_index}{skipFree();}
+
+        reference operator*() const {return *m_map->slotAt(m_index).object();}
+        pointer operator->() const {return m_map->slotAt(m_index).object();}
+        Handle handle() const {return m_map->handleAt(m_index);}
+
+        basic_iterator& operator++(){++m_index;skipFree();return *this;}
+        basic_iterator operator++(int){basic_iterator tmp=*this;++*this;return tmp;}
+
+        bool operator==(const basic_iterator& t_other) const {return m_index==t_other.m_index;}
+        bool operator!=(const basic_iterator& t_other) const {return m_index!=t_other.m_index;}
+    private:
+        void skipFree(){while(m_index<m_map->m_slot_count && !m_map->slotAt(m_index).occupied()) ++m_index;}
+
+        MapType* m_map;
+        std::size_t m_index;
+    };
+
+    using iterator = basic_iterator<T,SlotMap>;
+    using const_iterator = basic_iterator<const T,const SlotMap>;
+
+    iterator begin(){return iterator(this,0);}
+    iterator end(){return iterator(this,m_slot_count);}
+    const_iterator begin() const {return const_iterator(this,0);}
+    const_iterator end() const {return const_iterator(this,m_slot_count);}
+
+private:
+    struct Slot{
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::uint32_t generation=0;
+
+        bool occupied() const {return generation & 1u;}
+        T* object(){return std::launder(reinterpret_cast<T*>(storage));}
+        const T* object() const {return std::launder(reinterpret_cast<const T*>(storage));}
+    };
+
+    void destroyAll()
+    {
+        for(std::size_t i=0;i<m_slot_count;++i)
+        {
+            Slot& slot = slotAt(i);
+            if(slot.occupied())
+            {
+                slot.object()->~T();
+                ++slot.generation;
+            }
+        }
+        m_size=0;
+    }
+
+    Slot& slotAt(std::size_t t_index){return m_pages[t_index/PAGE_SIZE][t_index%PAGE_SIZE];}
+    const Slot& slotAt(std::size_t t_index) const {return m_pages[t_index/PAGE_SIZE][t_index%PAGE_SIZE];}
+
+    std::vector<std::unique_ptr<Slot[]>> m_pages;
+    std::vector<std::uint32_t> m_free_slots;
+    std::size_t m_slot_count=0;
+    std::size_t m_size=0;
+};
+
+#endif // SLOT_MAP_H
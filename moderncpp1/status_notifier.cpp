@@ -0,0 +1,194 @@
+#include "status_notifier.h"
+#include <algorithm>
+
+static std::atomic<std::uint64_t> next_notifier_id{1};
+//below this many changes a comparison sort beats clearing the 64K counters of the radix sort
+static const std::size_t RADIX_SORT_MIN_CHANGES = 2048;
+
+StatusNotifier::StatusNotifier(std::chrono::milliseconds t_interval)
+    :m_id{next_notifier_id++},m_interval{t_interval}
+{
+    m_thread = std::thread(&StatusNotifier::deliveryLoop,this);
+}
+
+StatusNotifier::~StatusNotifier()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+    std::lock_guard<std::mutex> lock(m_buffers_mutex);
+    for(const auto& buffer:m_buffers)
+        buffer->notifier_destroyed.store(true,std::memory_order_release);
+}
+
+StatusNotifier::SubscriptionId StatusNotifier::subscribe(Subscriber t_subscriber)
+{
+    std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+    m_subscribers.emplace_back(m_next_subscription,std::move(t_subscriber));
+    return m_next_subscription++;
+}
+
+void StatusNotifier::unsubscribe(SubscriptionId t_id)
+{
+    std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(),m_subscribers.end(),
+                                       [t_id](const auto& t_entry){return t_entry.first==t_id;}),
+                        m_subscribers.end());
+}
+
+void StatusNotifier::publish(const StatusChange& t_change)
+{
+    if(t_change.transitions==0)
+        return;
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.changes.push_back(t_change);
+    ++buffer.published;
+}
+
+void StatusNotifier::flush()
+{
+    deliver();
+}
+
+std::uint64_t StatusNotifier::publishedChanges() const
+{
+    std::lock_guard<std::mutex> lock(m_buffers_mutex);
+    std::uint64_t total = m_retired_published;
+    for(const auto& buffer:m_buffers)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        total += buffer->published;
+    }
+    return total;
+}
+
+StatusNotifier::ThreadBuffer& StatusNotifier::localBuffer()
+{
+    //keyed by a never reused id (not the address), so a new notifier at the address of a dead one is not confused with it.
+    //At thread exit every buffer is flagged, the notifiers drop them on their next delivery.
+    struct Entries{
+        std::vector<std::pair<std::uint64_t,std::shared_ptr<ThreadBuffer>>> list;
+        ~Entries()
+        {
+            for(auto& entry:list)
+                entry.second->thread_exited.store(true,std::memory_order_release);
+        }
+    };
+    thread_local Entries local_buffers;
+    for(auto& entry:local_buffers.list)
+        if(entry.first==m_id)
+            return *entry.second;
+
+    //a new notifier: forget the buffers of the destroyed ones first
+    auto& list = local_buffers.list;
+    list.erase(std::remove_if(list.begin(),list.end(),[](const auto& t_entry){
+                   return t_entry.second->notifier_destroyed.load(std::memory_order_acquire);}),list.end());
+    auto buffer = std::make_shared<ThreadBuffer>();
+    {
+        std::lock_guard<std::mutex> lock(m_buffers_mutex);
+        m_buffers.push_back(buffer);
+    }
+    list.emplace_back(m_id,buffer);
+    return *buffer;
+}
+
+void StatusNotifier::deliveryLoop()
+{
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    while(!m_stop)
+    {
+        m_wake.wait_for(lock,m_interval,[this]{return m_stop;});
+        lock.unlock();
+        deliver();
+        lock.lock();
+    }
+}
+
+void StatusNotifier::deliver()
+{
+    std::lock_guard<std::mutex> delivery_lock(m_delivery_mutex);
+    m_collected.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_buffers_mutex);
+        for(auto it=m_buffers.begin();it!=m_buffers.end();)
+        {
+            ThreadBuffer& buffer = **it;
+            //read before draining: once set, the thread published its last change
+            const bool exited = buffer.thread_exited.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> buffer_lock(buffer.mutex);
+                m_collected.insert(m_collected.end(),buffer.changes.begin(),buffer.changes.end());
+                buffer.changes.clear();        //keeps its capacity: a steady publisher stops allocating
+            }
+            if(exited)
+            {
+                m_retired_published += buffer.published;
+                it = m_buffers.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+    if(m_collected.empty())
+        return;
+
+    //group the changes by device. Storms: two stable counting-sort passes over the 16-bit halves of the id,
+    //O(n). Small batches: a comparison sort, which does not pay for the counters.
+    if(m_collected.size()<RADIX_SORT_MIN_CHANGES)
+        std::stable_sort(m_collected.begin(),m_collected.end(),[](const StatusChange& t_a,const StatusChange& t_b){
+            return static_cast<std::uint32_t>(t_a.device_id)<static_cast<std::uint32_t>(t_b.device_id);});
+    else
+    {
+        m_scratch.resize(m_collected.size());
+        for(int shift=0;shift<32;shift+=16)
+        {
+            m_counts.assign(65537,0);
+            for(const StatusChange& change:m_collected)
+                ++m_counts[(static_cast<std::uint32_t>(change.device_id)>>shift & 0xffff)+1];
+            for(std::size_t i=1;i<m_counts.size();++i)
+                m_counts[i] += m_counts[i-1];
+            for(const StatusChange& change:m_collected)
+                m_scratch[m_counts[static_cast<std::uint32_t>(change.device_id)>>shift & 0xffff]++] = change;
+            m_collected.swap(m_scratch);
+        }
+    }
+
+    //merge each group: "from" of its oldest change, "to" of its newest one. The versions give the order
+    //whichever threads published the changes (24-bit versions wrap around: compared as a signed distance)
+    auto older = [](std::uint32_t t_a,std::uint32_t t_b){return static_cast<std::int32_t>((t_a-t_b)<<8)<0;};
+    m_batch.clear();
+    std::uint32_t first_version = 0;
+    for(const StatusChange& change:m_collected)
+    {
+        if(m_batch.empty() || m_batch.back().device_id!=change.device_id)
+        {
+            m_batch.push_back(change);
+            first_version = change.version;
+            continue;
+        }
+        StatusChange& merged = m_batch.back();
+        merged.transitions += change.transitions;
+        if(older(change.version,first_version))
+        {
+            merged.from = change.from;
+            first_version = change.version;
+        }
+        if(older(merged.version,change.version))
+        {
+            merged.to = change.to;
+            merged.version = change.version;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_subscribers_mutex);
+        for(auto& subscriber:m_subscribers)
+            subscriber.second(m_batch);
+    }
+    m_delivered.fetch_add(m_collected.size(),std::memory_order_relaxed);
+    m_batches.fetch_add(1,std::memory_order_relaxed);
+}
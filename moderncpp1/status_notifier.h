@@ -0,0 +1,90 @@
+#ifndef STATUS_NOTIFIER_H
+#define STATUS_NOTIFIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "device.h"
+
+//Delivers device status changes to subscribers in coalesced batches instead of one call per change.
+//publish() only appends to a buffer owned by the calling thread. Every interval, a delivery thread
+//collects all the buffers and merges the changes of each device into one entry: first "from", last "to",
+//and the number of merged transitions. Each subscriber then gets a single call with the whole batch.
+//A status storm over 100k devices therefore costs a subscriber a few calls, not 100k.
+//A change published late (after a newer change of the same device was delivered) comes in the next batch:
+//compare StatusChange::version to spot it.
+class StatusNotifier{
+public:
+    typedef std::function<void(const std::vector<StatusChange>&)> Subscriber;
+    typedef std::size_t SubscriptionId;
+
+    explicit StatusNotifier(std::chrono::milliseconds t_interval=std::chrono::milliseconds(10));
+    StatusNotifier(const StatusNotifier&)=delete;
+    StatusNotifier& operator=(const StatusNotifier&)=delete;
+    //delivers what is still pending, then stops the delivery thread
+    ~StatusNotifier();
+
+    //subscribers are called on the delivery thread (or on the thread calling flush), one call at a time,
+    //and must not subscribe or unsubscribe from inside the call
+    SubscriptionId subscribe(Subscriber t_subscriber);
+    void unsubscribe(SubscriptionId t_id);
+
+    //hot path, callable from any thread: no-op changes (transitions==0) are ignored
+    void publish(const StatusChange& t_change);
+    //delivers everything published so far before returning
+    void flush();
+
+    std::uint64_t publishedChanges() const;
+    std::uint64_t deliveredChanges() const {return m_delivered.load(std::memory_order_relaxed);}
+    std::uint64_t deliveredBatches() const {return m_batches.load(std::memory_order_relaxed);}
+
+private:
+    //changes published by one thread: its mutex is only ever contended by a delivery.
+    //Shared by the notifier and the thread: each side flags when it is gone, so the other one can drop it.
+    struct ThreadBuffer{
+        std::mutex mutex;
+        std::vector<StatusChange> changes;
+        std::uint64_t published=0;
+        std::atomic<bool> thread_exited{false};         //no more publish: the next delivery drops it
+        std::atomic<bool> notifier_destroyed{false};    //the thread drops it when it needs a new buffer, or at exit
+    };
+
+    ThreadBuffer& localBuffer();
+    void deliveryLoop();
+    void deliver();
+
+    const std::uint64_t m_id;
+    const std::chrono::milliseconds m_interval;
+
+    mutable std::mutex m_buffers_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    std::uint64_t m_retired_published=0;        //published by the buffers of exited threads
+
+    std::mutex m_subscribers_mutex;
+    std::vector<std::pair<SubscriptionId,Subscriber>> m_subscribers;
+    SubscriptionId m_next_subscription=1;
+
+    //delivery state: only used under m_delivery_mutex
+    std::mutex m_delivery_mutex;
+    std::vector<StatusChange> m_collected;
+    std::vector<StatusChange> m_scratch;
+    std::vector<std::uint32_t> m_counts;
+    std::vector<StatusChange> m_batch;
+
+    std::atomic<std::uint64_t> m_delivered{0};
+    std::atomic<std::uint64_t> m_batches{0};
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    bool m_stop=false;
+    std::thread m_thread;
+};
+
+#endif // STATUS_NOTIFIER_H
@@ -0,0 +1,44 @@
+#include "string_interner.h"
+#include <mutex>
+#include <stdexcept>
+
+StringInterner& StringInterner::global()
+{
+    //never destroyed, like DeviceColdStore::global() which interns through it after main returns
+    static StringInterner* interner = new StringInterner;
+    return *interner;
+}
+
+StringInterner::Id StringInterner::intern(std::string_view t_text)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_ids.find(t_text);
+        if(it!=m_ids.end())
+            return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    //another thread may have added it between the two locks
+    auto it = m_ids.find(t_text);
+    if(it!=m_ids.end())
+        return it->second;
+    const std::string& stored = m_strings.emplace_back(t_text);
+    const Id id = static_cast<Id>(m_by_id.size());
+    m_by_id.push_back(stored);
+    m_ids.emplace(stored,id);
+    return id;
+}
+
+std::string_view StringInterner::lookup(Id t_id) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if(t_id>=m_by_id.size())
+        throw std::out_of_range("StringInterner: unknown id");
+    return m_by_id[t_id];
+}
+
+std::size_t StringInterner::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_by_id.size();
+}
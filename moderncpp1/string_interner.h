@@ -0,0 +1,33 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//Global string intern table: every distinct text is stored exactly once and identified by a small id.
+//Ids are stable for the life of the process and lookups return views into the stored strings.
+//Thread-safe: lookups share a reader lock, only a new string takes the writer lock.
+class StringInterner{
+public:
+    typedef std::uint32_t Id;
+
+    static StringInterner& global();
+
+    Id intern(std::string_view t_text);
+    //the view stays valid for the lifetime of the interner
+    std::string_view lookup(Id t_id) const;
+    std::size_t size() const;
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::deque<std::string> m_strings;          //deque: stored strings never move, so the views below stay valid
+    std::vector<std::string_view> m_by_id;
+    std::unordered_map<std::string_view,Id> m_ids;
+};
+
+#endif // STRING_INTERNER_H
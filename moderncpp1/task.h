@@ -0,0 +1,139 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+//Lazily started coroutine returning a T (C++20).
+//A Task does nothing until it is co_awaited: the awaiting coroutine is suspended, the task runs and,
+//when it finishes, resumes the awaiting coroutine directly (symmetric transfer, no stack growth).
+//Exceptions thrown by the task are rethrown at the co_await. Top level tasks are started by Reactor::spawn.
+template<typename T=void>
+class Task;
+
+namespace detail{
+
+template<typename T>
+class TaskPromise;
+
+class TaskPromiseBase{
+public:
+    std::suspend_always initial_suspend() noexcept {return {};}
+
+    //resumes whoever awaited the task, or returns to the resumer when nobody did
+    struct FinalAwaiter{
+        bool await_ready() noexcept {return false;}
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> t_handle) noexcept
+        {
+            std::coroutine_handle<> continuation = t_handle.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept {return {};}
+
+    void unhandled_exception() {m_exception = std::current_exception();}
+    void setContinuation(std::coroutine_handle<> t_continuation) {m_continuation = t_continuation;}
+
+protected:
+    void rethrowIfFailed()
+    {
+        if(m_exception)
+            std::rethrow_exception(m_exception);
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase{
+public:
+    Task<T> get_return_object();
+    template<typename U>
+    void return_value(U&& t_value) {m_value.emplace(std::forward<U>(t_value));}
+    T result()
+    {
+        rethrowIfFailed();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase{
+public:
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {rethrowIfFailed();}
+};
+
+}
+
+template<typename T>
+class Task{
+public:
+    typedef detail::TaskPromise<T> promise_type;
+
+    Task(Task&& t_source) noexcept :m_handle{std::exchange(t_source.m_handle,nullptr)}{}
+    Task& operator=(Task&& t_source) noexcept
+    {
+        if(this!=&t_source)
+        {
+            if(m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(t_source.m_handle,nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&)=delete;
+    Task& operator=(const Task&)=delete;
+    ~Task()
+    {
+        if(m_handle)
+            m_handle.destroy();
+    }
+
+    bool done() const {return !m_handle || m_handle.done();}
+
+    //co_await task: runs the task and yields its result
+    auto operator co_await() noexcept
+    {
+        struct Awaiter{
+            std::coroutine_handle<promise_type> m_handle;
+            bool await_ready() noexcept {return m_handle.done();}
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> t_awaiting) noexcept
+            {
+                m_handle.promise().setContinuation(t_awaiting);
+                return m_handle;
+            }
+            T await_resume() {return m_handle.promise().result();}
+        };
+        return Awaiter{m_handle};
+    }
+
+private:
+    friend class detail::TaskPromise<T>;
+    explicit Task(std::coroutine_handle<promise_type> t_handle):m_handle{t_handle}{}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename T>
+Task<T> detail::TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+#endif // TASK_H
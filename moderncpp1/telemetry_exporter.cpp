@@ -0,0 +1,139 @@
+#include "telemetry_exporter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
+TelemetryExporter::TelemetryExporter(int t_fd,std::size_t t_rows_per_batch,std::size_t t_chunk_size)
+    :m_fd{t_fd},m_owns_fd{false},m_rows_per_batch{std::max<std::size_t>(t_rows_per_batch,1)},m_chunk(std::max<std::size_t>(t_chunk_size,64))
+{
+    m_ids.reserve(m_rows_per_batch);
+    m_types.reserve(m_rows_per_batch);
+    m_statuses.reserve(m_rows_per_batch);
+    m_fill.reserve(m_rows_per_batch);
+}
+
+TelemetryExporter::TelemetryExporter(const std::string& t_path,std::size_t t_rows_per_batch,std::size_t t_chunk_size)
+    :TelemetryExporter(::open(t_path.c_str(),O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,0644),t_rows_per_batch,t_chunk_size)
+{
+    if(m_fd<0)
+        throw std::system_error(errno,std::generic_category(),"TelemetryExporter: cannot open "+t_path);
+    m_owns_fd = true;
+}
+
+TelemetryExporter::~TelemetryExporter()
+{
+    try
+    {
+        finish();
+    }
+    catch(const std::system_error&)
+    {
+        //destructors must not throw: a failing target simply loses the tail of the stream
+    }
+    if(m_owns_fd)
+        ::close(m_fd);
+}
+
+void TelemetryExporter::exportSnapshot(const DeviceRegistry& t_registry)
+{
+    if(!m_header_written)
+        writeHeader();
+    for(const Device& device:t_registry)
+    {
+        m_ids.push_back(device.getId());
+        m_types.push_back(static_cast<std::uint8_t>(device.getTypeCode()));
+        m_statuses.push_back(static_cast<std::uint8_t>(device.getStatusCode()));
+        m_fill.push_back(static_cast<std::uint32_t>(device.getDataSize()));
+        if(m_ids.size()==m_rows_per_batch)
+            writeBatch();
+    }
+    writeBatch();
+}
+
+void TelemetryExporter::finish()
+{
+    if(m_finished)
+        return;
+    m_finished = true;
+    if(!m_header_written)
+        writeHeader();
+    putValue<std::uint32_t>(0);
+    flushChunk();
+}
+
+void TelemetryExporter::writeHeader()
+{
+    m_header_written = true;
+    put("DTEL",4);
+    putValue<std::uint16_t>(FORMAT_VERSION);
+    putValue<std::uint16_t>(0);
+
+    //dictionary: enum code -> label, so the batches only carry one byte per enum value
+    putValue<std::uint8_t>(DEVICE_TYPE_COUNT);
+    for(int code=0;code<DEVICE_TYPE_COUNT;++code)
+    {
+        const std::string& label = Device::typeLabel(static_cast<DEVICE_TYPE>(code));
+        putValue<std::uint8_t>(static_cast<std::uint8_t>(code));
+        putValue<std::uint8_t>(static_cast<std::uint8_t>(label.size()));
+        put(label.data(),label.size());
+    }
+    putValue<std::uint8_t>(DEVICE_STATUS_COUNT);
+    for(int code=0;code<DEVICE_STATUS_COUNT;++code)
+    {
+        const std::string& label = Device::statusLabel(static_cast<DEVICE_STATUS>(code));
+        putValue<std::uint8_t>(static_cast<std::uint8_t>(code));
+        putValue<std::uint8_t>(static_cast<std::uint8_t>(label.size()));
+        put(label.data(),label.size());
+    }
+}
+
+void TelemetryExporter::writeBatch()
+{
+    const std::size_t rows = m_ids.size();
+    if(rows==0)
+        return;
+    putValue<std::uint32_t>(static_cast<std::uint32_t>(rows));
+    put(m_ids.data(),rows*sizeof(m_ids[0]));
+    put(m_types.data(),rows*sizeof(m_types[0]));
+    put(m_statuses.data(),rows*sizeof(m_statuses[0]));
+    put(m_fill.data(),rows*sizeof(m_fill[0]));
+    m_rows_written += rows;
+    m_ids.clear();
+    m_types.clear();
+    m_statuses.clear();
+    m_fill.clear();
+}
+
+void TelemetryExporter::put(const void* t_data,std::size_t t_size)
+{
+    const char* data = static_cast<const char*>(t_data);
+    while(t_size>0)
+    {
+        const std::size_t count = std::min(t_size,m_chunk.size()-m_chunk_used);
+        std::memcpy(m_chunk.data()+m_chunk_used,data,count);
+        m_chunk_used += count;
+        data += count;
+        t_size -= count;
+        if(m_chunk_used==m_chunk.size())
+            flushChunk();
+    }
+}
+
+void TelemetryExporter::flushChunk()
+{
+    std::size_t offset = 0;
+    while(offset<m_chunk_used)
+    {
+        const ssize_t n = ::write(m_fd,m_chunk.data()+offset,m_chunk_used-offset);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<0)
+            throw std::system_error(errno,std::generic_category(),"TelemetryExporter: write failed");
+        offset += static_cast<std::size_t>(n);
+    }
+    m_bytes_written += m_chunk_used;
+    m_chunk_used = 0;
+}
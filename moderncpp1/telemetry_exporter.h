@@ -0,0 +1,66 @@
+#ifndef TELEMETRY_EXPORTER_H
+#define TELEMETRY_EXPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "device_registry.h"
+
+//Streaming, columnar export of device state snapshots to a file or pipe.
+//
+//Stream layout (integers in host byte order):
+//  header      "DTEL" | u16 version | u16 reserved
+//  dictionary  u8 type count,   then per type:   u8 code | u8 length | label bytes
+//              u8 status count, then per status: u8 code | u8 length | label bytes      (written once per stream)
+//  batches     u32 row count (0 = end of stream) | i32 id[rows] | u8 type[rows] | u8 status[rows] | u32 buffer_fill[rows]
+//
+//Every snapshot is split into batches of at most rows_per_batch rows and all output goes through one
+//fixed-size chunk buffer, so the exporter does one write(2) per chunk and no allocation per device.
+class TelemetryExporter{
+public:
+    static const std::uint16_t FORMAT_VERSION = 1;
+
+    //exports to an already open file descriptor (e.g. a pipe), which is not closed by the exporter
+    explicit TelemetryExporter(int t_fd,std::size_t t_rows_per_batch=4096,std::size_t t_chunk_size=64*1024);
+    //exports to a new file (truncated)
+    explicit TelemetryExporter(const std::string& t_path,std::size_t t_rows_per_batch=4096,std::size_t t_chunk_size=64*1024);
+    TelemetryExporter(const TelemetryExporter&)=delete;
+    TelemetryExporter& operator=(const TelemetryExporter&)=delete;
+    //finishes the stream (end marker) if finish() was not called
+    ~TelemetryExporter();
+
+    //appends one snapshot of every device in the registry
+    void exportSnapshot(const DeviceRegistry& t_registry);
+    //writes the end-of-stream marker and flushes the chunk buffer
+    void finish();
+
+    std::uint64_t rowsWritten() const {return m_rows_written;}
+    std::uint64_t bytesWritten() const {return m_bytes_written;}
+
+private:
+    void writeHeader();
+    void writeBatch();
+    void put(const void* t_data,std::size_t t_size);
+    template<typename T> void putValue(T t_value){put(&t_value,sizeof(t_value));}
+    void flushChunk();
+
+    int m_fd;
+    bool m_owns_fd;
+    bool m_finished=false;
+    bool m_header_written=false;
+    std::size_t m_rows_per_batch;
+    std::vector<char> m_chunk;
+    std::size_t m_chunk_used=0;
+
+    //column staging area, reused for every batch
+    std::vector<std::int32_t> m_ids;
+    std::vector<std::uint8_t> m_types;
+    std::vector<std::uint8_t> m_statuses;
+    std::vector<std::uint32_t> m_fill;
+
+    std::uint64_t m_rows_written=0;
+    std::uint64_t m_bytes_written=0;
+};
+
+#endif // TELEMETRY_EXPORTER_H
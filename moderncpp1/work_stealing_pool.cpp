@@ -0,0 +1,276 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+//a range of chunks [first,last) packed in one word, so deque entries can be plain atomics
+static std::uint64_t packRange(std::uint64_t t_first,std::uint64_t t_last) {return t_first<<32 | t_last;}
+static const std::uint64_t MAX_CHUNKS = 0xffffffffu;
+//failed rounds of stealing before an idle participant goes to sleep
+static const unsigned IDLE_ROUNDS_BEFORE_PARKING = 16;
+
+//set while a thread works for a pool: a nested parallelFor on the same pool runs inline
+static thread_local const WorkStealingPool* current_pool = nullptr;
+
+void WorkStealingPool::RangeDeque::push(std::uint64_t t_range)
+{
+    const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    m_ranges[bottom%CAPACITY].store(t_range,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom+1,std::memory_order_relaxed);
+}
+
+bool WorkStealingPool::RangeDeque::pop(std::uint64_t& t_range)
+{
+    const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed)-1;
+    m_bottom.store(bottom,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_top.load(std::memory_order_relaxed);
+    if(top>bottom)
+    {
+        m_bottom.store(bottom+1,std::memory_order_relaxed);
+        return false;
+    }
+    t_range = m_ranges[bottom%CAPACITY].load(std::memory_order_relaxed);
+    if(top==bottom)
+    {
+        //last entry: a thief may be taking it at the same time, the top CAS decides
+        const bool won = m_top.compare_exchange_strong(top,top+1,std::memory_order_seq_cst,std::memory_order_relaxed);
+        m_bottom.store(bottom+1,std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool WorkStealingPool::RangeDeque::steal(std::uint64_t& t_range)
+{
+    std::int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if(top>=bottom)
+        return false;
+    t_range = m_ranges[top%CAPACITY].load(std::memory_order_relaxed);
+    return m_top.compare_exchange_strong(top,top+1,std::memory_order_seq_cst,std::memory_order_relaxed);
+}
+
+bool WorkStealingPool::RangeDeque::empty() const
+{
+    return m_top.load(std::memory_order_relaxed)>=m_bottom.load(std::memory_order_relaxed);
+}
+
+WorkStealingPool::WorkStealingPool(WorkStealingOptions t_options)
+{
+    unsigned threads = t_options.threads ? t_options.threads : std::thread::hardware_concurrency();
+    threads = std::max(threads,1u);
+    for(unsigned i=0;i<threads;++i)
+    {
+        m_participants.push_back(std::make_unique<Participant>());
+        m_participants.back()->random_state = 0x9E3779B97F4A7C15ull*(i+1);
+    }
+    for(unsigned i=1;i<threads;++i)
+        m_workers.emplace_back([this,i,pin=t_options.pin_threads]{
+            if(pin)
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(i%std::max(1u,std::thread::hardware_concurrency()),&cpus);
+                ::pthread_setaffinity_np(::pthread_self(),sizeof(cpus),&cpus);  //best effort: may be refused
+            }
+            workerLoop(i);
+        });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for(std::thread& worker:m_workers)
+        worker.join();
+}
+
+std::uint64_t WorkStealingPool::steals() const
+{
+    std::uint64_t total = 0;
+    for(const auto& participant:m_participants)
+        total += participant->steals.load(std::memory_order_relaxed);
+    return total;
+}
+
+void WorkStealingPool::run(std::size_t t_count,std::size_t t_chunk,Invoke t_invoke,void* t_context)
+{
+    if(t_count==0)
+        return;
+    if(current_pool==this)
+    {
+        t_invoke(t_context,0,t_count);
+        return;
+    }
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+    //automatic chunking: about 16 chunks per participant, enough for the stealing to even out uneven costs
+    std::size_t chunk = t_chunk ? t_chunk : std::max<std::size_t>(1,t_count/(16*m_participants.size()));
+    std::size_t chunks = (t_count+chunk-1)/chunk;
+    if(chunks>MAX_CHUNKS)
+    {
+        chunk = (t_count+MAX_CHUNKS-1)/MAX_CHUNKS;
+        chunks = (t_count+chunk-1)/chunk;
+    }
+
+    m_invoke = t_invoke;
+    m_context = t_context;
+    m_count = t_count;
+    m_chunk = chunk;
+    m_failed.store(false,std::memory_order_relaxed);
+    m_failure = nullptr;
+    m_remaining_chunks.store(chunks,std::memory_order_release);
+    m_participants[0]->deque.push(packRange(0,chunks));
+    if(chunks>1 && !m_workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wake_mutex);
+            ++m_job_generation;
+        }
+        m_wake.notify_all();
+    }
+
+    current_pool = this;
+    participate(0);
+    current_pool = nullptr;
+    if(m_failure)
+        std::rethrow_exception(m_failure);
+}
+
+void WorkStealingPool::workerLoop(unsigned t_index)
+{
+    current_pool = this;
+    std::uint64_t seen_generation = 0;
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_wake_mutex);
+            m_wake.wait(lock,[&]{return m_stop || m_job_generation!=seen_generation;});
+            if(m_stop)
+                return;
+            seen_generation = m_job_generation;
+        }
+        participate(t_index);
+    }
+}
+
+void WorkStealingPool::participate(unsigned t_index)
+{
+    std::uint64_t range;
+    unsigned failed_rounds = 0;
+    while(m_remaining_chunks.load(std::memory_order_acquire)>0)
+    {
+        if(findWork(t_index,range))
+        {
+            failed_rounds = 0;
+            execute(t_index,range);
+        }
+        else if(++failed_rounds<IDLE_ROUNDS_BEFORE_PARKING)
+            std::this_thread::yield();     //the last chunks are running elsewhere
+        else
+        {
+            park();
+            failed_rounds = 0;
+        }
+    }
+}
+
+bool WorkStealingPool::workAvailable() const
+{
+    for(const auto& participant:m_participants)
+        if(!participant->deque.empty())
+            return true;
+    return false;
+}
+
+//sleeps until a range is pushed or the job ends. m_parked is raised before the deques are checked a last time
+//and read by a pusher after its push, with seq_cst fences on both sides: either the range is seen here or
+//the pusher wakes the parked participants.
+void WorkStealingPool::park()
+{
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    const std::uint64_t signal = m_work_signal;
+    lock.unlock();
+    m_parked.fetch_add(1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_remaining_chunks.load(std::memory_order_acquire)>0 && !workAvailable())
+    {
+        lock.lock();
+        m_work_available.wait(lock,[&]{return m_work_signal!=signal;});
+    }
+    m_parked.fetch_sub(1,std::memory_order_relaxed);
+}
+
+void WorkStealingPool::wakeParked()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        ++m_work_signal;
+    }
+    m_work_available.notify_all();
+}
+
+bool WorkStealingPool::findWork(unsigned t_index,std::uint64_t& t_range)
+{
+    Participant& self = *m_participants[t_index];
+    if(self.deque.pop(t_range))
+        return true;
+    const std::size_t count = m_participants.size();
+    for(std::size_t attempt=0;attempt<count;++attempt)
+    {
+        std::uint64_t& state = self.random_state;
+        state ^= state<<13;
+        state ^= state>>7;
+        state ^= state<<17;
+        const std::size_t victim = state%count;
+        if(victim!=t_index && m_participants[victim]->deque.steal(t_range))
+        {
+            self.steals.fetch_add(1,std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(unsigned t_index,std::uint64_t t_range)
+{
+    std::uint64_t first = t_range>>32;
+    std::uint64_t last = t_range&0xffffffffu;
+    //keep the lower half, offer the upper half to thieves, until one chunk is left
+    const bool split = last-first>1;
+    while(last-first>1)
+    {
+        const std::uint64_t middle = first+(last-first)/2;
+        m_participants[t_index]->deque.push(packRange(middle,last));
+        last = middle;
+    }
+    if(split)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_parked.load(std::memory_order_relaxed)>0)
+            wakeParked();
+    }
+    if(!m_failed.load(std::memory_order_relaxed))
+    {
+        const std::size_t begin = static_cast<std::size_t>(first)*m_chunk;
+        try
+        {
+            m_invoke(m_context,begin,std::min(m_count,begin+m_chunk));
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(m_failure_mutex);
+            if(!m_failure)
+                m_failure = std::current_exception();
+            m_failed.store(true,std::memory_order_relaxed);
+        }
+    }
+    //the last chunk: the parked participants go back to waiting for the next job
+    if(m_remaining_chunks.fetch_sub(1,std::memory_order_acq_rel)==1)
+        wakeParked();
+}
@@ -0,0 +1,112 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct WorkStealingOptions{
+    unsigned threads=0;         //participants including the calling thread, 0: std::thread::hardware_concurrency()
+    bool pin_threads=false;     //pin worker i to CPU i (the calling thread is left alone)
+};
+
+//Thread pool for data-parallel loops whose iterations have very uneven costs (e.g. servicing devices).
+//parallelFor splits the index range into chunks. A participant owns a deque of chunk ranges: it keeps
+//halving the range it holds, pushing the upper half on its deque, until a single chunk is left to run.
+//Idle participants steal the oldest (largest) range of a randomly chosen victim, so expensive chunks
+//end up spread over every core without any up-front partitioning. A participant that found nothing to
+//steal a few rounds in a row sleeps until a range is pushed or the loop ends.
+//The calling thread takes part in the loop. One parallelFor runs at a time; a parallelFor called from
+//inside a loop body runs inline on the calling worker.
+class WorkStealingPool{
+public:
+    explicit WorkStealingPool(WorkStealingOptions t_options=WorkStealingOptions{});
+    WorkStealingPool(const WorkStealingPool&)=delete;
+    WorkStealingPool& operator=(const WorkStealingPool&)=delete;
+    ~WorkStealingPool();
+
+    //calls t_body(i) for every i in [0,t_count), in chunks of t_chunk indexes (0: automatic), and returns
+    //once all are done. The first exception thrown by t_body skips the chunks not started yet and is
+    //rethrown here.
+    template<typename Body>
+    void parallelFor(std::size_t t_count,std::size_t t_chunk,Body&& t_body)
+    {
+        auto invoke = [](void* t_context,std::size_t t_begin,std::size_t t_end){
+            Body& body = *static_cast<std::remove_reference_t<Body>*>(t_context);
+            for(std::size_t i=t_begin;i<t_end;++i)
+                body(i);
+        };
+        run(t_count,t_chunk,invoke,const_cast<void*>(static_cast<const void*>(&t_body)));
+    }
+
+    unsigned threadCount() const {return static_cast<unsigned>(m_participants.size());}
+    //ranges taken from another participant's deque since the pool started
+    std::uint64_t steals() const;
+
+private:
+    //Chase-Lev deque of chunk ranges. Splitting halves the range every time, so a participant never holds
+    //more than one entry per level: a fixed ring of 64 entries is enough for 2^32 chunks.
+    class RangeDeque{
+    public:
+        static const std::int64_t CAPACITY = 64;
+        void push(std::uint64_t t_range);
+        bool pop(std::uint64_t& t_range);       //owner only, newest entry
+        bool steal(std::uint64_t& t_range);     //any thread, oldest entry
+        bool empty() const;
+    private:
+        alignas(64) std::atomic<std::int64_t> m_top{0};
+        alignas(64) std::atomic<std::int64_t> m_bottom{0};
+        std::atomic<std::uint64_t> m_ranges[CAPACITY];
+    };
+
+    struct alignas(64) Participant{
+        RangeDeque deque;
+        std::uint64_t random_state=0;
+        std::atomic<std::uint64_t> steals{0};
+    };
+
+    typedef void (*Invoke)(void*,std::size_t,std::size_t);
+
+    void run(std::size_t t_count,std::size_t t_chunk,Invoke t_invoke,void* t_context);
+    void workerLoop(unsigned t_index);
+    //works on the current job until no chunk is left anywhere
+    void participate(unsigned t_index);
+    bool findWork(unsigned t_index,std::uint64_t& t_range);
+    void execute(unsigned t_index,std::uint64_t t_range);
+    bool workAvailable() const;
+    void park();
+    void wakeParked();
+
+    std::vector<std::unique_ptr<Participant>> m_participants;     //0 is the thread calling parallelFor
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_run_mutex;     //one parallelFor at a time
+    //current job, published by the release store of m_remaining_chunks
+    Invoke m_invoke=nullptr;
+    void* m_context=nullptr;
+    std::size_t m_count=0;
+    std::size_t m_chunk=1;
+    std::atomic<std::uint64_t> m_remaining_chunks{0};
+    std::atomic<bool> m_failed{false};
+    std::exception_ptr m_failure;
+    std::mutex m_failure_mutex;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::uint64_t m_job_generation=0;
+    bool m_stop=false;
+
+    //idle participants of the current job: woken by a push or the end of the job
+    std::condition_variable m_work_available;
+    std::uint64_t m_work_signal=0;              //under m_wake_mutex
+    std::atomic<unsigned> m_parked{0};
+};
+
+#endif // WORK_STEALING_POOL_H